@@ -0,0 +1,39 @@
+
+#include <config.h>
+
+/*
+ * bench                              - list benchmarks
+ * bench <name|group> [n] [rounds]    - run them
+ */
+
+int
+main(string cmd, string arg)
+{
+  mapping marks;
+  string *names, what, text;
+  int     n, rounds, i;
+
+  if(!MASTER->query_player_level("admin"))
+    return 0;
+
+  if(!arg)
+  {
+    marks = BENCH_D->query_benchmarks();
+    names = sort_array(m_indices(marks), "string_gt", this_object());
+    text = "";
+    for(i = 0; i < sizeof(names); i++)
+      text += sprintf("%-20s %s\n", names[i], marks[names[i]][0]);
+    this_player()->catch_message("bench", text);
+    return 1;
+  }
+  if(sscanf(arg, "%s %d %d", what, n, rounds) < 2)
+    what = arg;
+  write(BENCH_D->run(what, n, rounds));
+  return 1;
+}
+
+int
+string_gt(string a, string b)
+{
+  return a > b;
+}
@@ -0,0 +1,100 @@
+
+#include <config.h>
+
+/*
+ * census                 - live objects per program
+ * census diff [from] [to] - changes between snapshots, 0 is the latest
+ * census orphans          - where unattended clones pile up, as of the
+ *                           last scan; starts a new one
+ */
+
+#define TOP_PROGRAMS	20
+
+static mapping sort_by;
+
+int
+by_count(string a, string b)
+{
+  return sort_by[a] < sort_by[b];
+}
+
+static string *
+top(mapping m)
+{
+  string *keys;
+
+  sort_by = m;
+  keys = sort_array(m_indices(m), "by_count", this_object());
+  sort_by = 0;
+  if(sizeof(keys) > TOP_PROGRAMS)
+    keys = keys[0..TOP_PROGRAMS - 1];
+  return keys;
+}
+
+int
+main(string cmd, string arg)
+{
+  mapping live, rates, m;
+  string *progs, *growing, text;
+  int     from, to, i;
+
+  if(!MASTER->query_player_level("admin"))
+    return 0;
+  if(!arg)
+  {
+    live = CENSUS_D->query_live();
+    rates = CENSUS_D->query_rates();
+    growing = CENSUS_D->query_growing();
+    progs = top(live);
+    text = sprintf("%-36s %8s %8s\n", "Program", "Live", "New/min");
+    for(i = 0; i < sizeof(progs); i++)
+      text += sprintf("%-36s %8d %8d %s\n", progs[i], live[progs[i]],
+		      rates[progs[i]],
+		      member_array(progs[i], growing) != -1 ? "growing" : "");
+    if(sizeof(growing))
+      text += "Growing in every recent snapshot: " +
+	implode(growing, ", ") + "\n";
+    this_player()->catch_message("census", text);
+    return 1;
+  }
+  if(arg == "orphans")
+  {
+    text = "";
+    if(m = CENSUS_D->query_orphans())
+    {
+      progs = top(m);
+      text = sprintf("%-40s %8s\n", "Environment", "Objects");
+      for(i = 0; i < sizeof(progs); i++)
+	text += sprintf("%-40s %8d\n", progs[i], m[progs[i]]);
+      text += "Scanned " + ctime(CENSUS_D->query_orphans_time())[4..18] +
+	".\n";
+    }
+    if(CENSUS_D->scan_orphans())
+      text += "A new scan has started; you will be told when it is done.\n";
+    else
+      text += "A scan is running.\n";
+    this_player()->catch_message("census", text);
+    return 1;
+  }
+  if(arg == "diff" || sscanf(arg, "diff %d %d", from, to) == 2 ||
+     sscanf(arg, "diff %d", from) == 1)
+  {
+    if(arg == "diff" || sscanf(arg, "diff %d %d", from, to) != 2)
+      to = -1;
+    if(!(m = CENSUS_D->query_diff(from, to)))
+    {
+      write("There are " + CENSUS_D->query_snapshots() + " snapshots.\n");
+      return 1;
+    }
+    progs = top(m);
+    text = "";
+    for(i = 0; i < sizeof(progs); i++)
+      text += sprintf("%-36s %8s\n", progs[i],
+		      (m[progs[i]] > 0 ? "+" : "") + m[progs[i]]);
+    this_player()->catch_message("census", sizeof(progs) ? text :
+				 "No changes.\n");
+    return 1;
+  }
+  write("Usage: census [diff [from] [to]|orphans]\n");
+  return 1;
+}
@@ -0,0 +1,61 @@
+
+#include <config.h>
+
+/*
+ * chan                        - list channels
+ * chan join|leave <channel>
+ * chan history <channel>
+ * chan <channel> <message>
+ */
+
+int
+main(string cmd, string arg)
+{
+  string *chans, *mine, what, text;
+  int     i;
+
+  if(!arg)
+  {
+    chans = CHANNEL_D->query_channels(0);
+    mine = CHANNEL_D->query_channels(this_player());
+    text = "";
+    for(i = 0; i < sizeof(chans); i++)
+      text += sprintf("%-12s %4d members %s\n", chans[i],
+		      CHANNEL_D->query_members(chans[i]),
+		      member_array(chans[i], mine) != -1 ? "(joined)" : "");
+    this_player()->catch_message("chan", text);
+    return 1;
+  }
+  if(sscanf(arg, "join %s", what))
+  {
+    if(!(i = CHANNEL_D->join(this_player(), what)))
+      write("You are already on " + what + ".\n");
+    else if(i < 0)
+      write("You can't open a channel called " + what + ".\n");
+    else
+      this_player()->catch_message("chan", "You join " + what + ".\n" +
+				   CHANNEL_D->query_history(what));
+    return 1;
+  }
+  if(sscanf(arg, "leave %s", what))
+  {
+    if(!CHANNEL_D->leave(this_player(), what))
+      write("You aren't on " + what + ".\n");
+    else
+      write("You leave " + what + ".\n");
+    return 1;
+  }
+  if(sscanf(arg, "history %s", what))
+  {
+    this_player()->catch_message("chan", CHANNEL_D->query_history(what));
+    return 1;
+  }
+  if(sscanf(arg, "%s %s", what, text) == 2)
+  {
+    if(!CHANNEL_D->send(this_player(), what, text))
+      write("You aren't on " + what + ".\n");
+    return 1;
+  }
+  write("Usage: chan [join|leave|history <channel>|<channel> <message>]\n");
+  return 1;
+}
@@ -0,0 +1,70 @@
+
+#include <config.h>
+
+/*
+ * errors [path]                  - latest error of every file under path
+ * errors <file> all              - the errors kept for one file
+ * errors <path> <minutes> [text] - errors in the last minutes, as far
+ *                                  back as the recent errors kept in
+ *                                  memory; older ones are only in the
+ *                                  day files under /log/errors
+ */
+
+static string
+format(mixed *recs, int full)
+{
+  string text, msg;
+  int    i;
+
+  text = "";
+  for(i = 0; i < sizeof(recs); i++)
+  {
+    msg = recs[i][5];
+    if(!full)
+      msg = explode(msg + "\n", "\n")[0] + "\n";
+    text += sprintf("%s %-10s %s:%d\n  %s", ctime(recs[i][0])[4..18],
+		    recs[i][1], recs[i][2], recs[i][4], msg);
+  }
+  return strlen(text) ? text : "No errors.\n";
+}
+
+int
+main(string cmd, string arg)
+{
+  mixed *recs;
+  string path, text, note;
+  int    mins, oldest;
+
+  if(!MASTER->query_player_level("wizard"))
+    return 0;
+  if(!arg)
+  {
+    this_player()->catch_message("errors", format(ERROR_D->query_latest(0),
+						  0));
+    return 1;
+  }
+  if(sscanf(arg, "%s all", path) == 1)
+  {
+    this_player()->catch_message("errors",
+				 format(ERROR_D->query_file(path), 1));
+    return 1;
+  }
+  if(sscanf(arg, "%s %d %s", path, mins, text) == 3 ||
+     sscanf(arg, "%s %d", path, mins) == 2)
+  {
+    if(path[0] != '/')
+      path = "/" + path;
+    recs = ERROR_D->query_errors(path, time() - mins * 60, text);
+    note = "";
+    if((oldest = ERROR_D->query_oldest()) && oldest > time() - mins * 60)
+      note = "Only errors since " + ctime(oldest)[4..18] +
+	" are searched; older ones are in /log/errors.\n";
+    this_player()->catch_message("errors", format(recs, 0) + note);
+    return 1;
+  }
+  if(arg[0] != '/')
+    arg = "/" + arg;
+  this_player()->catch_message("errors", format(ERROR_D->query_latest(arg),
+						0));
+  return 1;
+}
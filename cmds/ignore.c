@@ -0,0 +1,24 @@
+
+#include <config.h>
+
+int
+main(string cmd, string arg)
+{
+  string *ign;
+
+  if(!arg)
+  {
+    ign = this_player()->query_ignoring() || ({ });
+    if(!sizeof(ign))
+      write("You aren't ignoring anyone.\n");
+    else
+      write("You are ignoring: " + implode(ign, ", ") + ".\n");
+    return 1;
+  }
+  arg = lower_case(arg);
+  if(CHANNEL_D->ignore(this_player(), arg))
+    write("You ignore " + capitalize(arg) + ".\n");
+  else
+    write("You listen to " + capitalize(arg) + " again.\n");
+  return 1;
+}
@@ -0,0 +1,48 @@
+
+#include <config.h>
+
+/*
+ * jobs                  - list background jobs
+ * jobs cancel <id>
+ * jobs budget <eval>    - eval cost the jobs may use per tick
+ */
+
+int
+main(string cmd, string arg)
+{
+  mixed *list;
+  string text;
+  int    *n, id, i;
+
+  if(!MASTER->query_player_level("admin"))
+    return 0;
+  if(arg && sscanf(arg, "cancel %d", id) == 1)
+  {
+    write(JOB_D->cancel(id) ? "Ok\n" : "No such job, or not yours.\n");
+    return 1;
+  }
+  if(arg && sscanf(arg, "budget %d", id) == 1)
+  {
+    JOB_D->set_budget(id);
+    write("Budget is " + JOB_D->query_budget() + " per tick.\n");
+    return 1;
+  }
+  if(arg)
+  {
+    write("Usage: jobs [cancel <id>|budget <eval>]\n");
+    return 1;
+  }
+  list = JOB_D->query_jobs();
+  text = sprintf("%4s %-24s %-12s %-10s %7s %10s %9s\n", "Id", "Job", "Class",
+		 "Owner", "Steps", "Eval", "Progress");
+  for(i = 0; i < sizeof(list); i++)
+    text += sprintf("%4d %-24s %-12s %-10s %7d %10d %9s\n", list[i][0],
+		    list[i][1], list[i][2], list[i][3] || "-", list[i][4],
+		    list[i][5], list[i][7] ? list[i][6] * 100 / list[i][7] + "%"
+					  : "-");
+  n = JOB_D->query_counts();
+  text += n[0] + " running, " + n[1] + " finished, " + n[2] + " failed, " +
+    "budget " + JOB_D->query_budget() + " eval per tick.\n";
+  this_player()->catch_message("jobs", text);
+  return 1;
+}
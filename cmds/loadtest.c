@@ -0,0 +1,36 @@
+
+#include <config.h>
+
+/*
+ * loadtest start <bots> [seconds]
+ * loadtest stop
+ * loadtest             - report on the running or last test
+ */
+
+int
+main(string cmd, string arg)
+{
+  int n, secs;
+
+  if(!MASTER->query_player_level("admin"))
+    return 0;
+
+  if(!arg)
+  {
+    write(LOADTEST_D->report());
+    return 1;
+  }
+  if(arg == "stop")
+  {
+    LOADTEST_D->stop();
+    return 1;
+  }
+  secs = 60;
+  if(sscanf(arg, "start %d %d", n, secs) >= 1 && n > 0 && secs > 0)
+  {
+    write(LOADTEST_D->start(n, secs));
+    return 1;
+  }
+  write("Usage: loadtest [start <bots> [seconds]|stop]\n");
+  return 1;
+}
@@ -6,13 +6,16 @@ main(string cmd, string args)
   object *inv;
 
   inv = all_inventory(environment(this_player()));
-  write(environment(this_player())->query_long());
-  map_array(inv - ({ this_player() }), "map_fun", this_object());
+  this_player()->catch_message("look",
+			       environment(this_player())->query_long() +
+			       implode(map_array(inv - ({ this_player() }),
+						 "map_fun", this_object()),
+				       ""));
   return 1;
 }
 
-void
+string
 map_fun(object ob)
 {
-  write(ob->query_short() + "\n");
+  return ob->query_short() + "\n";
 }
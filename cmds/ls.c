@@ -1,11 +1,83 @@
 
+#include <config.h>
+
+#define SHORT_PAGE	120
+#define LONG_PAGE	20
+
+string
+format_page(mixed *entries, int long)
+{
+  string *lines;
+  int     i;
+
+  lines = allocate(sizeof(entries));
+  for(i = 0; i < sizeof(entries); i++)
+  {
+    if(!long)
+      lines[i] = entries[i][0] + (entries[i][1] == -2 ? "/" : "");
+    else
+      lines[i] = sprintf("%-30s %8s  %s", entries[i][0],
+			 entries[i][1] == -2 ? "<dir>" : entries[i][1] + "",
+			 ctime(entries[i][2])[4..15]);
+  }
+  if(!long)
+    return sprintf("%-79#s\n", implode(lines, "\n"));
+  return implode(lines, "\n") + "\n";
+}
+
 int
 main(string cdm, string args)
 {
+  mixed  *entries, *rev;
+  string  flags, order;
+  int     long, reverse, i;
+
+  flags = "";
+  if(args && sscanf(args, "-%s %s", flags, args) != 2 &&
+     sscanf(args, "-%s", flags) == 1)
+    args = 0;
   if(!args)
     args = "/";
+  if(args[0] != '/')
+    args = "/" + args;
   if(args[strlen(args)-1] != '/')
     args += "/";
-  printf("%-79#s\n", implode(get_dir(args), "\n"));
+
+  order = "name";
+  for(i = 0; i < strlen(flags); i++)
+  {
+    switch(flags[i])
+    {
+    case 'l': long = 1;        break;
+    case 't': order = "date";  break;
+    case 'S': order = "size";  break;
+    case 'r': reverse = 1;     break;
+    default:
+      write("Usage: ls [-lrtS] [dir]\n");
+      return 1;
+    }
+  }
+
+  entries = DIR_CACHE->query_listing(args, order);
+  if(!entries)
+  {
+    write("No such directory: " + args + "\n");
+    return 1;
+  }
+  if(!sizeof(entries))
+  {
+    write(args + " is empty.\n");
+    return 1;
+  }
+  if(reverse)
+  {
+    rev = allocate(sizeof(entries));
+    for(i = 0; i < sizeof(entries); i++)
+      rev[i] = entries[sizeof(entries) - 1 - i];
+    entries = rev;
+  }
+
+  this_player()->more(entries, long ? LONG_PAGE : SHORT_PAGE, this_object(),
+		      "format_page", long);
   return 1;
 }
@@ -0,0 +1,64 @@
+
+#include <config.h>
+
+/*
+ * mudlist                              - known muds and intermud stats
+ * mudlist ping|who <mud>|<host> <port>
+ *
+ * Only admins may name a host and port that isn't a known mud.
+ */
+
+int
+main(string cmd, string arg)
+{
+  mapping muds, st;
+  string *names;
+  mixed  *addr;
+  string  req, where, host, text;
+  int     port, i;
+
+  if(!arg)
+  {
+    muds = INTERMUD_D->query_muds();
+    names = m_indices(muds);
+    text = "";
+    for(i = 0; i < sizeof(names); i++)
+      text += sprintf("%-20s %-16s %6d %s\n", names[i], muds[names[i]][0],
+		      muds[names[i]][1], ctime(muds[names[i]][2])[4..15]);
+    st = INTERMUD_D->query_stats();
+    text += sprintf("Received %d, dropped %d, bad %d, sent %d, queued %d/%d.\n",
+		    st["received"], st["dropped"], st["bad"], st["sent"],
+		    st["inbox"], st["outbox"]);
+    this_player()->catch_message("mudlist", text);
+    return 1;
+  }
+  if(sscanf(arg, "%s %s", req, where) != 2 ||
+     (req != "ping" && req != "who"))
+  {
+    write("Usage: mudlist [ping|who <mud>|<host> <port>]\n");
+    return 1;
+  }
+  if(sscanf(where, "%s %d", host, port) == 2)
+  {
+    if(!MASTER->query_player_level("admin"))
+    {
+      write("Only admins may send to an address.\n");
+      return 1;
+    }
+  }
+  else
+  {
+    if(!(addr = INTERMUD_D->query_mud(where)))
+    {
+      write("Unknown mud: " + where + "\n");
+      return 1;
+    }
+    host = addr[0];
+    port = addr[1];
+  }
+  if(INTERMUD_D->request(host, port, req, 0))
+    write("Ok\n");
+  else
+    write("The intermud queue is full.\n");
+  return 1;
+}
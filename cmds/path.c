@@ -0,0 +1,46 @@
+
+#include <config.h>
+
+/*
+ * path <player>|<room>  - the way from here to a player or a room
+ */
+
+int
+main(string cmd, string arg)
+{
+  object *us;
+  string *verbs;
+  mixed   dest;
+  int     i;
+
+  if(!arg)
+  {
+    write("Usage: path <player>|<room>\n");
+    return 1;
+  }
+  us = users();
+  for(i = 0; i < sizeof(us); i++)
+    if(us[i]->query_real_name() == lower_case(arg))
+      dest = environment(us[i]);
+  if(!dest)
+  {
+    if(arg[0] != '/')
+      arg = "/" + arg;
+    if(!(dest = find_object(arg)) ||
+       !function_exists("query_dest_dir", dest))
+    {
+      write("There is no such player or loaded room.\n");
+      return 1;
+    }
+  }
+
+  verbs = MAP_D->query_route(environment(this_player()), dest);
+  if(!verbs)
+    write("You don't know the way there.\n");
+  else if(!sizeof(verbs))
+    write("You are already there.\n");
+  else
+    write("Go " + implode(verbs, ", ") + " (" + sizeof(verbs) + " step" +
+	  (sizeof(verbs) == 1 ? "" : "s") + ").\n");
+  return 1;
+}
@@ -0,0 +1,39 @@
+
+#include <config.h>
+
+/*
+ * pool  - clone pool sizes and hit rates per program
+ */
+
+int
+main(string cmd, string arg)
+{
+  mapping st;
+  string *progs, text;
+  int    *t;
+  int     i;
+
+  if(!MASTER->query_player_level("admin"))
+    return 0;
+  st = POOL_D->query_stats();
+  progs = sort_array(m_indices(st), "by_name", this_object());
+  text = sprintf("%-32s %6s %7s %7s %7s %7s %5s\n", "Program", "Free",
+		 "Hits", "Misses", "Pooled", "Killed", "Hit%");
+  for(i = 0; i < sizeof(progs); i++)
+    text += sprintf("%-32s %6d %7d %7d %7d %7d %5d\n", progs[i],
+		    st[progs[i]][0], st[progs[i]][1], st[progs[i]][2],
+		    st[progs[i]][3], st[progs[i]][4],
+		    st[progs[i]][1] * 100 /
+		      (st[progs[i]][1] + st[progs[i]][2] || 1));
+  t = POOL_D->query_totals();
+  text += t[0] + " clones pooled, emptied " + t[1] +
+    " times for lack of memory.\n";
+  this_player()->catch_message("pool", text);
+  return 1;
+}
+
+int
+by_name(string a, string b)
+{
+  return a > b;
+}
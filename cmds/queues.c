@@ -0,0 +1,34 @@
+
+#include <config.h>
+
+int
+main(string cmd, string arg)
+{
+  object *us;
+  mapping st, in;
+  string  text;
+  int    *d;
+  int     i, bytes, lines;
+
+  us = users();
+  text = sprintf("%-16s %7s %7s %7s %7s %6s %6s %7s\n", "Player", "Queued",
+		 "Bytes", "Peak", "Dropped", "Input", "Peak", "Dropped");
+  for(i = 0; i < sizeof(us); i++)
+  {
+    if(!(st = us[i]->query_output_stats()))
+      continue;
+    in = us[i]->query_input_stats() || ([ ]);
+    text += sprintf("%-16s %7d %7d %7d %7d %6d %6d %7d\n",
+		    capitalize(us[i]->query_real_name() + ""),
+		    st["queued"], st["bytes"], st["peak"], st["dropped"],
+		    in["queued"], in["peak"], in["dropped"]);
+    bytes += st["bytes"];
+    lines += in["queued"];
+  }
+  d = INPUT_D->query_stats();
+  text += "Total queued output: " + bytes + " bytes.\n" +
+    "Total queued input: " + lines + " lines from " + d[0] + " players, " +
+    d[1] + " lines run late so far.\n";
+  this_player()->catch_message("queues", text);
+  return 1;
+}
@@ -0,0 +1,8 @@
+
+int
+main(string cmd, string arg)
+{
+  write("Saving. Bye!\n");
+  this_player()->quit();
+  return 1;
+}
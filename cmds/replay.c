@@ -0,0 +1,44 @@
+
+#include <config.h>
+
+/*
+ * replay                              - status and sessions
+ * replay record|stop-record
+ * replay run <session> [speed] [tag]  - replay with bots, save as <tag>
+ * replay stop
+ * replay compare <tag> <tag>
+ */
+
+int
+main(string cmd, string arg)
+{
+  string *files, session, tag, a, b;
+  int     speed;
+
+  if(!MASTER->query_player_level("admin"))
+    return 0;
+  if(!arg)
+  {
+    files = get_dir(SESSION_DIR + "/*") || ({ });
+    this_player()->catch_message("replay", REPLAY_D->query_status() +
+				 "Sessions and reports: " +
+				 implode(files, ", ") + "\n");
+    return 1;
+  }
+  if(arg == "record")
+    write(REPLAY_D->start_recording());
+  else if(arg == "stop-record")
+    write(REPLAY_D->stop_recording());
+  else if(arg == "stop")
+    write(REPLAY_D->stop_replay());
+  else if(sscanf(arg, "compare %s %s", a, b) == 2)
+    this_player()->catch_message("replay", REPLAY_D->compare(a, b));
+  else if(sscanf(arg, "run %s %d %s", session, speed, tag) == 3 ||
+	  sscanf(arg, "run %s %d", session, speed) == 2 ||
+	  sscanf(arg, "run %s", session) == 1)
+    write(REPLAY_D->replay(session, speed, tag));
+  else
+    write("Usage: replay [record|stop-record|run <session> [speed] [tag]|" +
+	  "stop|compare <tag> <tag>]\n");
+  return 1;
+}
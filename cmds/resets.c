@@ -0,0 +1,38 @@
+
+#include <config.h>
+
+/*
+ * resets  - rooms, resets and eval cost per reset slot
+ */
+
+int
+main(string cmd, string arg)
+{
+  mixed *slots;
+  string text;
+  int   *cu;
+  int    i, rooms, resets, skipped;
+
+  if(!MASTER->query_player_level("admin"))
+    return 0;
+  slots = RESET_D->query_slots();
+  text = sprintf("%4s %6s %7s %7s %10s %10s\n", "Slot", "Rooms", "Resets",
+		 "Skipped", "Last eval", "Max eval");
+  for(i = 0; i < sizeof(slots); i++)
+  {
+    if(!slots[i][0])
+      continue;
+    text += sprintf("%4d %6d %7d %7d %10d %10d%s\n", i, slots[i][0],
+		    slots[i][1], slots[i][2], slots[i][3], slots[i][4],
+		    i == RESET_D->query_current() ? " <" : "");
+    rooms += slots[i][0];
+    resets += slots[i][1];
+    skipped += slots[i][2];
+  }
+  cu = RESET_D->query_catch_ups();
+  text += rooms + " rooms, " + resets + " resets, " + skipped +
+    " skipped, " + cu[0] + " caught up on entry (" +
+    (cu[0] ? cu[1] / cu[0] : 0) + " eval each).\n";
+  this_player()->catch_message("resets", text);
+  return 1;
+}
@@ -1,3 +1,6 @@
+
+#include <config.h>
+
 int
 main(string cmd, string arg)
 {
@@ -5,6 +8,7 @@ main(string cmd, string arg)
 
   objs = all_inventory(environment(this_player()));
   map_array(objs, "say_fun", this_object(), arg);
+  EVENT_D->dispatch(environment(this_player()), "say", this_player(), arg);
 
   return 1;
 }
@@ -0,0 +1,97 @@
+
+#include <config.h>
+
+/*
+ * sefun            - show the simul_efun objects and modules
+ * sefun reload     - recompile the modules and the main simul_efun object
+ * sefun spare      - reload the spare object from the current sources
+ */
+
+static string *
+modules()
+{
+  string *files;
+  int     i;
+
+  files = get_dir(SEFUN_DIR + "/*.c") - ({ "spare.c" });
+  for(i = 0; i < sizeof(files); i++)
+    files[i] = SEFUN_DIR + "/" + files[i][0..strlen(files[i]) - 3];
+  return files;
+}
+
+static string
+reload(string file)
+{
+  object ob;
+
+  if(ob = find_object(file))
+    destruct(ob);
+  return catch(call_other(file, "gurksallad"));
+}
+
+static void
+status()
+{
+  string *mods;
+  int     i;
+
+  write(sprintf("%-28s %s\n", SIMUL_EFUN,
+		find_object(SIMUL_EFUN) ? "loaded" : "not loaded"));
+  write(sprintf("%-28s %s\n", SEFUN_SPARE,
+		find_object(SEFUN_SPARE) ? "loaded" : "not loaded"));
+  mods = modules();
+  for(i = 0; i < sizeof(mods); i++)
+    write(sprintf("  %-26s %s\n", mods[i],
+		  find_object(mods[i]) ? "loaded" : "not loaded"));
+}
+
+int
+main(string cmd, string arg)
+{
+  string *mods, err;
+  int     i;
+
+  if(!MASTER->query_player_level("admin"))
+    return 0;
+  seteuid(getuid());
+
+  if(!arg)
+  {
+    status();
+    return 1;
+  }
+
+  switch(arg)
+  {
+  case "reload":
+    mods = modules();
+    for(i = 0; i < sizeof(mods); i++)
+    {
+      if(err = reload(mods[i]))
+      {
+	write(mods[i] + ": " + err + "Reload aborted, simul_efuns unchanged.\n");
+	return 1;
+      }
+    }
+    catch(SIMUL_EFUN->flush_logs());
+    if(err = reload(SIMUL_EFUN))
+      write(SIMUL_EFUN + ": " + err + "The spare object takes over.\n");
+    else
+      write("Ok\n");
+    return 1;
+
+  case "spare":
+    if(!find_object(SIMUL_EFUN))
+    {
+      write("The main simul_efun object isn't loaded, keeping the spare.\n");
+      return 1;
+    }
+    if(err = reload(SEFUN_SPARE))
+      write(SEFUN_SPARE + ": " + err);
+    else
+      write("Ok\n");
+    return 1;
+  }
+  write("Usage: sefun [reload|spare]\n");
+  return 1;
+}
@@ -0,0 +1,41 @@
+
+#include <config.h>
+
+/*
+ * top [minute|hour|day] [commands|eval|heart_beats|objects]
+ */
+
+#define TOP_UIDS	15
+
+int
+main(string cmd, string arg)
+{
+  mixed  *top;
+  string  period, field, text;
+  int     i;
+
+  if(!MASTER->query_player_level("admin"))
+    return 0;
+  period = "hour";
+  field = "eval";
+  if(arg && sscanf(arg, "%s %s", period, field) != 2)
+    period = arg;
+  if(!(top = ACCOUNT_D->query_top(period, field, TOP_UIDS)))
+  {
+    write("Usage: top [minute|hour|day] [commands|eval|heart_beats|objects]\n");
+    return 1;
+  }
+  if(ACCOUNT_D->query_samples() < 2)
+  {
+    write("No usage recorded yet.\n");
+    return 1;
+  }
+  text = sprintf("Top %s over the last %s:\n%-16s %10s %14s %12s %8s\n",
+		 field, period, "Uid", "Commands", "Eval cost",
+		 "Heart beats", "Objects");
+  for(i = 0; i < sizeof(top); i++)
+    text += sprintf("%-16s %10d %14d %12d %8s\n", top[i][0] + "", top[i][1],
+		    top[i][2], top[i][3], top[i][4] ? top[i][4] + "" : "-");
+  this_player()->catch_message("top", text);
+  return 1;
+}
@@ -0,0 +1,43 @@
+
+#include <config.h>
+
+/*
+ * trace                              - show the last trace report
+ * trace <player|object> [calls] [secs]
+ * trace stop
+ */
+
+int
+main(string cmd, string arg)
+{
+  object *us, ob;
+  string  what;
+  int     calls, secs, i;
+
+  if(!MASTER->query_player_level("trace"))
+    return 0;
+  if(!arg)
+  {
+    this_player()->catch_message("trace", TRACE_D->query_report());
+    return 1;
+  }
+  if(arg == "stop")
+  {
+    write(TRACE_D->stop());
+    return 1;
+  }
+  if(sscanf(arg, "%s %d %d", what, calls, secs) != 3 &&
+     sscanf(arg, "%s %d", what, calls) != 2)
+    what = arg;
+  us = users();
+  for(i = 0; i < sizeof(us); i++)
+    if(us[i]->query_real_name() == lower_case(what))
+      ob = us[i];
+  if(!ob && !(ob = find_object(what)))
+  {
+    write("No such player or object: " + what + "\n");
+    return 1;
+  }
+  write(TRACE_D->start(ob, calls, secs));
+  return 1;
+}
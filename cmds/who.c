@@ -2,12 +2,14 @@
 int
 main(string cmd, string arg)
 {
-  map_array(users(), "who_fun", this_object());
+  this_player()->catch_message("who",
+			       implode(map_array(users(), "who_fun",
+						 this_object()), ""));
   return 1;
 }
 
-void
+string
 who_fun(object ob)
 {
-  write(capitalize(ob->query_real_name()) + "\n");
+  return capitalize(ob->query_real_name()) + "\n";
 }
@@ -5,9 +5,51 @@
 
 #define LOGIN_OBJ	"/secure/login"
 #define PLAYER_OBJ	"/obj/player/player"
+#define BOT_OBJ		"/obj/bot"
 
 #define START		"/room/start"
+#define VOID		"/room/void"
 
 #define ROOT_EUID	"Root"
+#define ADMINS		({ "admin" })
+/*
+ * "name:crypted password" lines. An admin without a line chooses their
+ * password at their first login, so log in as every name in ADMINS
+ * right after installing. To reset a password, remove its line.
+ */
+#define ADMIN_PASSWD	"/secure/admins"
 
-#define BIN_DIR		"/cmds"
\ No newline at end of file
+#define MASTER		"/secure/master"
+#define SIMUL_EFUN	"/secure/simul_efun"
+#define SEFUN_SPARE	"/secure/sefun/spare"
+#define SEFUN_DIR	"/secure/sefun"
+
+#define BIN_DIR		"/cmds"
+#define SAVE_DIR	"/save/players"
+
+#define DIR_CACHE	"/secure/dircache"
+#define NETDEAD_D	"/secure/netdead"
+#define LOADTEST_D	"/secure/loadtest"
+#define BENCH_D		"/secure/bench"
+#define BENCH_DIR	"/secure/bench"
+#define MAP_D		"/secure/mapd"
+#define EVENT_D		"/secure/eventd"
+#define CHANNEL_D	"/secure/channeld"
+#define TRACE_D		"/secure/traced"
+#define TRACER		"/secure/tracer"
+#define TRACE_DIR	"/secure/trace"
+#define ACCOUNT_D	"/secure/accountd"
+#define INTERMUD_D	"/secure/intermud"
+#define JOB_D		"/secure/jobd"
+#define CENSUS_D	"/secure/census"
+#define RESET_D		"/secure/resetd"
+#define RESET_TIME	3600
+#define POOL_D		"/secure/poold"
+#define INPUT_D		"/secure/inputd"
+#define REPLAY_D	"/secure/replayd"
+#define SESSION_DIR	"/log/sessions"
+#define SNAPSHOT_D	"/secure/snapshotd"
+#define METRICS_D	"/secure/metricsd"
+#define ERROR_D		"/secure/errord"
+
+#define PRELOADS	({ ERROR_D, CENSUS_D, NETDEAD_D, ACCOUNT_D, METRICS_D })
@@ -0,0 +1,12 @@
+
+/*
+ * Indices into the entries returned by wizlist_info().
+ */
+
+#define WL_NAME		0
+#define WL_COMMANDS	1
+#define WL_EVAL_COST	2
+#define WL_HEART_BEATS	3
+#define WL_CALL_OUT	4
+#define WL_ARRAY_TOTAL	5
+#define WL_EXTRA	6
@@ -0,0 +1,49 @@
+/*
+ * bot.c
+ *
+ * A synthetic player for load tests. It runs the real player code but
+ * has no connection; output is only counted.
+ */
+
+inherit "/obj/player/player";
+
+static int msgs_seen, bytes_seen;
+
+void
+start(string name)
+{
+  enable_commands();
+  enter_game(name);
+  input_exempt = 1;
+  recording = 0;
+}
+
+/*
+ * Run one input line through the normal action parser, the same way
+ * the driver does for a connected player.
+ */
+int
+run(string line)
+{
+  return command(line);
+}
+
+void
+catch_message(string type, string mess)
+{
+  msgs_seen++;
+  bytes_seen += strlen(mess);
+}
+
+void
+catch_tell(string mess)
+{
+  msgs_seen++;
+  bytes_seen += strlen(mess);
+}
+
+int *
+query_output_seen()
+{
+  return ({ msgs_seen, bytes_seen });
+}
@@ -2,8 +2,26 @@ inherit "obj/object";
 
 #include <config.h>
 
+/*
+ * Stats like hp regenerate without a heart_beat. Each stat keeps its
+ * value at the time it was last changed and its rate, and the current
+ * value is worked out when it is asked for. Values are kept in
+ * sixtieths so rates per minute add up exactly. The only call_out is
+ * one for the next time a stat runs full or empty, which calls
+ * stat_full() or stat_empty(). A living that nothing happens to costs
+ * nothing.
+ */
+
+#define S_VALUE		0	/* value * 60 at S_LAST */
+#define S_MAX		1
+#define S_RATE		2	/* change per minute */
+#define S_LAST		3
+
 string real_name;
 
+static mapping stats = ([ ]);		/* name : ({ value, max, rate, last }) */
+static int     stats_suspended;
+
 string
 query_real_name()
 {
@@ -16,3 +34,185 @@ move_player(mixed dest)
   move(dest);
   return 1;
 }
+
+/*
+ * Bring the stored value of stat <s> up to now.
+ */
+static void
+anchor(mixed *s)
+{
+  int now;
+
+  now = time();
+  if(!stats_suspended)
+    s[S_VALUE] += (now - s[S_LAST]) * s[S_RATE];
+  if(s[S_VALUE] > s[S_MAX] * 60)
+    s[S_VALUE] = s[S_MAX] * 60;
+  if(s[S_VALUE] < 0)
+    s[S_VALUE] = 0;
+  s[S_LAST] = now;
+}
+
+/*
+ * Seconds until stat <s> runs full or empty, or -1 if it doesn't.
+ */
+static int
+time_to_threshold(mixed *s)
+{
+  if(s[S_RATE] > 0 && s[S_VALUE] < s[S_MAX] * 60)
+    return (s[S_MAX] * 60 - s[S_VALUE] + s[S_RATE] - 1) / s[S_RATE];
+  if(s[S_RATE] < 0 && s[S_VALUE] > 0)
+    return (s[S_VALUE] - s[S_RATE] - 1) / -s[S_RATE];
+  return -1;
+}
+
+static void
+schedule_threshold()
+{
+  string *names;
+  int     next, t, i;
+
+  remove_call_out("stat_threshold");
+  if(stats_suspended)
+    return;
+  next = -1;
+  names = m_indices(stats);
+  for(i = 0; i < sizeof(names); i++)
+  {
+    anchor(stats[names[i]]);
+    t = time_to_threshold(stats[names[i]]);
+    if(t >= 0 && (next < 0 || t < next))
+      next = t;
+  }
+  if(next >= 0)
+    call_out("stat_threshold", next);
+}
+
+void
+stat_full(string name)
+{
+}
+
+void
+stat_empty(string name)
+{
+}
+
+void
+stat_threshold()
+{
+  string *names;
+  mixed  *s;
+  int     i;
+
+  names = m_indices(stats);
+  for(i = 0; i < sizeof(names); i++)
+  {
+    s = stats[names[i]];
+    if(time_to_threshold(s) < 0)
+      continue;
+    anchor(s);
+    if(s[S_RATE] > 0 && s[S_VALUE] >= s[S_MAX] * 60)
+      stat_full(names[i]);
+    else if(s[S_RATE] < 0 && s[S_VALUE] <= 0)
+      stat_empty(names[i]);
+  }
+  schedule_threshold();
+}
+
+void
+set_stat(string name, int value, int max, int rate)
+{
+  stats[name] = ({ value * 60, max, rate, time() });
+  anchor(stats[name]);
+  schedule_threshold();
+}
+
+int
+query_stat(string name)
+{
+  mixed *s;
+
+  if(!(s = stats[name]))
+    return 0;
+  anchor(s);
+  return s[S_VALUE] / 60;
+}
+
+int
+query_stat_max(string name)
+{
+  return stats[name] ? stats[name][S_MAX] : 0;
+}
+
+void
+set_stat_rate(string name, int rate)
+{
+  if(!stats[name])
+    return;
+  anchor(stats[name]);
+  stats[name][S_RATE] = rate;
+  schedule_threshold();
+}
+
+/*
+ * Change stat <name> by <delta>. Returns the new value.
+ */
+int
+add_stat(string name, int delta)
+{
+  mixed *s;
+
+  if(!(s = stats[name]))
+    return 0;
+  anchor(s);
+  s[S_VALUE] += delta * 60;
+  anchor(s);
+  if(delta < 0 && s[S_VALUE] <= 0)
+    stat_empty(name);
+  else if(delta > 0 && s[S_VALUE] >= s[S_MAX] * 60)
+    stat_full(name);
+  schedule_threshold();
+  return s[S_VALUE] / 60;
+}
+
+/*
+ * Stop and restart all regeneration, e.g. while a player is linkdead.
+ */
+void
+suspend_stats()
+{
+  string *names;
+  int     i;
+
+  names = m_indices(stats);
+  for(i = 0; i < sizeof(names); i++)
+    anchor(stats[names[i]]);
+  stats_suspended = 1;
+  remove_call_out("stat_threshold");
+}
+
+/*
+ * The stats part of recycle(), see /obj/object.
+ */
+static int
+recycle_living()
+{
+  remove_call_out("stat_threshold");
+  stats = ([ ]);
+  stats_suspended = 0;
+  return recycle_object();
+}
+
+void
+resume_stats()
+{
+  string *names;
+  int     i;
+
+  names = m_indices(stats);
+  for(i = 0; i < sizeof(names); i++)
+    stats[names[i]][S_LAST] = time();
+  stats_suspended = 0;
+  schedule_threshold();
+}
@@ -1,14 +1,98 @@
 
+#include <config.h>
+
+static string *events;		/* room events this object listens to */
+
 void
 create()
 {
   seteuid(getuid());
+  CENSUS_D->created(this_object());
 }
 
 int
 move(mixed dest)
 {
+  object from;
+
+  from = environment();
   move_object(this_object(), dest);
+  EVENT_D->moved(this_object(), from, environment(), events);
   return 1;
 }
 
+/*
+ * Listen to room events, see /secure/eventd. They arrive through
+ * receive_event(event, who, data).
+ */
+void
+subscribe(string *what)
+{
+  what -= events ? events : ({ });
+  events = events ? events + what : what;
+  EVENT_D->subscribe(this_object(), what);
+}
+
+void
+unsubscribe(string *what)
+{
+  if(!events)
+    return;
+  events -= what;
+  EVENT_D->unsubscribe(this_object(), what);
+}
+
+string *
+query_events()
+{
+  return events;
+}
+
+void
+receive_event(string event, mixed who, mixed data)
+{
+}
+
+/*
+ * State to keep over a warm restart, see /secure/snapshotd. It is given
+ * back to restore_snapshot() in a fresh clone.
+ */
+mixed
+query_snapshot()
+{
+  return 0;
+}
+
+void
+restore_snapshot(mixed data)
+{
+}
+
+/*
+ * Called by /secure/poold before this object is parked for reuse. Return
+ * 1 to be pooled, 0 to be destructed instead. Pooling is opt-in: an
+ * object that can be reused overrides this, resets its own state,
+ * call_outs included, and returns recycle_object(), which resets what
+ * is kept here.
+ */
+int
+recycle()
+{
+  return 0;
+}
+
+/*
+ * Reset the state of this file for reuse. Returns 0 if the object still
+ * holds something, which is never reused.
+ */
+static int
+recycle_object()
+{
+  if(first_inventory(this_object()))
+    return 0;
+  set_heart_beat(0);
+  if(events)
+    EVENT_D->unsubscribe(this_object(), events);
+  events = 0;
+  return 1;
+}
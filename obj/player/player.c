@@ -3,18 +3,105 @@ inherit "/obj/living";
 
 #include <config.h>
 
+#define OUTPUT_MAX_BYTES	16384	/* cap on text held for one player */
+#define PAGE_LINES		22
+#define PAGE_BYTES		1024	/* shorter messages are never paged */
+#define TRUNCATED		"\n[output truncated]\n"
+#define DROPPABLE		({ "say", "channel", "shout" })
+#define BUCKET_SIZE		10	/* commands a player may burst */
+#define BUCKET_RATE		4	/* commands per second after that */
+#define MAX_INPUT_QUEUE		20
+
 static mapping commands = ([ ]);
+string        *ignoring = ({ });
 
-void
+static string *out_queue = ({ });	/* pending text, oldest first */
+static string *out_types = ({ });
+static int     out_bytes, out_peak, out_dropped, out_dropped_total;
+static int     paging;
+static mixed  *more_source;	/* ({ items, pos, chunk, ob, fun, arg }) */
+
+static int     netdead;		/* time the link was lost, 0 if linked */
+static int     quitting;		/* set by quit(), so the lost link and
+					   the destruct don't count */
+
+static string *in_queue = ({ });	/* input lines waiting for tokens */
+static int     tokens = BUCKET_SIZE, bucket_time;
+static int     input_exempt, draining, recording;
+static int     admin;		/* set by the login after the password */
+static int     in_peak, in_dropped, in_limited;
+
+static mapping sections = ([ ]);	/* loaded sections : value */
+static mapping dirty = ([ ]);		/* sections changed since saved */
+
+/*
+ * Players are saved with encode_data() as a small core file,
+ * SAVE_DIR/<name>.o, and a file per section, SAVE_DIR/<name>.<section>.
+ * Sections hold state that is rarely needed, like history, mail or the
+ * quest log. Only the core is read at login; a section is read the
+ * first time it is asked for, and only changed sections are written.
+ */
+static string
+save_file(string section)
+{
+  return SAVE_DIR + "/" + real_name + "." + (section || "o");
+}
+
+static void
+write_save(string file, string data)
+{
+  rm(file + ".new");
+  write_file(file + ".new", data);
+  rm(file);
+  rename(file + ".new", file);
+}
+
+int
 restore_me()
 {
-  return 0;
+  mapping core;
+
+  if(!(core = decode_data(read_file(save_file(0)))))
+    return 0;
+  ignoring = core["ignoring"] || ({ });
+  return 1;
 }
 
-void 
+void
 save_me()
 {
-  return 0;
+  string *names;
+  int     i;
+
+  if(!real_name)
+    return;
+  if(file_size(SAVE_DIR) != -2)
+  {
+    if(file_size("/save") != -2)
+      mkdir("/save");
+    mkdir(SAVE_DIR);
+  }
+  write_save(save_file(0), encode_data(([ "ignoring" : ignoring,
+					  "saved"    : time() ])));
+  names = m_indices(dirty);
+  for(i = 0; i < sizeof(names); i++)
+    write_save(save_file(names[i]), encode_data(sections[names[i]]));
+  dirty = ([ ]);
+}
+
+mixed
+query_section(string name)
+{
+  if(member_array(name, m_indices(sections)) == -1)
+    sections[name] = decode_data(read_file(save_file(name)));
+  return sections[name];
+}
+
+void
+set_section(string name, mixed value)
+{
+  sections[name] = value;
+  dirty[name] = 1;
 }
 
 int
@@ -43,11 +130,92 @@ add_commands()
   add_action("command_hook", "", 1);
 }
 
+static void
+refill()
+{
+  tokens += (time() - bucket_time) * BUCKET_RATE;
+  if(tokens > BUCKET_SIZE)
+    tokens = BUCKET_SIZE;
+  bucket_time = time();
+}
+
+/*
+ * Rate limit the command being parsed. Each command takes a token from
+ * a bucket of BUCKET_SIZE that refills by BUCKET_RATE per second. Without
+ * tokens, or with lines already waiting, the line is queued and run by
+ * /secure/inputd when tokens are back; a full queue drops it. Returns 1
+ * if the command was queued or dropped and must not run now.
+ */
+int
+throttle_input(string arg)
+{
+  string line;
+  object rec;
+
+  if(draining || this_player() != this_object())
+    return 0;
+  if(recording && (rec = find_object(REPLAY_D)))
+    rec->record(real_name, query_verb() + (arg ? " " + arg : ""));
+  if(input_exempt)
+    return 0;
+  refill();
+  if(!sizeof(in_queue) && tokens > 0)
+  {
+    tokens--;
+    return 0;
+  }
+  line = query_verb() + (arg ? " " + arg : "");
+  in_limited++;
+  if(sizeof(in_queue) >= MAX_INPUT_QUEUE)
+  {
+    in_dropped++;
+    tell_object(this_object(), "You are sending commands too fast, \"" +
+		line + "\" was dropped.\n");
+    return 1;
+  }
+  if(!sizeof(in_queue))
+  {
+    tell_object(this_object(),
+		"You are sending commands too fast, slowing down.\n");
+    INPUT_D->queued(this_object());
+  }
+  in_queue += ({ line });
+  if(sizeof(in_queue) > in_peak)
+    in_peak = sizeof(in_queue);
+  return 1;
+}
+
+/*
+ * Called by the input daemon. Runs the next queued line if there is a
+ * token for it and returns the number of lines still waiting, or -1 if
+ * it is out of tokens.
+ */
+int
+run_queued()
+{
+  string line;
+
+  if(previous_object() != find_object(INPUT_D) || !sizeof(in_queue))
+    return 0;
+  refill();
+  if(tokens <= 0)
+    return -1;
+  tokens--;
+  line = in_queue[0];
+  in_queue = in_queue[1..sizeof(in_queue) - 1];
+  draining = 1;
+  catch(command(line));
+  draining = 0;
+  return sizeof(in_queue);
+}
+
 int
 command_hook(string arg)
 {
   string cmd;
 
+  if(throttle_input(arg))
+    return 1;
   cmd = commands[query_verb()];
   if(cmd)
   {
@@ -59,20 +227,348 @@ command_hook(string arg)
 int
 enter_game(string my_name)
 {
+  object ob;
+  string dest;
+
   real_name = my_name;
   restore_me();
+  input_exempt = admin;
+  if(ob = find_object(REPLAY_D))
+    recording = ob->query_recording();
   add_commands();
-  move_player(START);
+  CHANNEL_D->login(this_object());
+  if(!(ob = find_object(SNAPSHOT_D)) ||
+     !(dest = ob->claim_location(real_name)) || catch(move_player(dest)) ||
+     !environment())
+    move_player(START);
+}
+
+void
+set_admin()
+{
+  string prog;
+  int    n;
+
+  if(sscanf(file_name(previous_object()), "%s#%d", prog, n) == 2 &&
+     "/" + prog == LOGIN_OBJ)
+    admin = 1;
+}
+
+int
+query_admin()
+{
+  return admin;
+}
+
+string *
+query_ignoring()
+{
+  return ignoring;
+}
+
+void
+set_ignoring(string *names)
+{
+  ignoring = names;
+}
+
+/*
+ * Players are never pooled.
+ */
+int
+recycle()
+{
+  return 0;
+}
+
+void
+quit()
+{
+  if(this_player() != this_object())
+    return;
+  quitting = 1;
+  save_me();
+  CHANNEL_D->logout(this_object());
+  if(environment())
+    tell_room(environment(), capitalize(real_name) + " leaves the game.\n",
+	      ({ this_object() }));
+  destruct(this_object());
 }
 
 string
 query_short()
 {
+  if(netdead)
+    return capitalize(real_name) + " (statue)";
   return capitalize(real_name);
 }
 
+/*
+ * Called by the netdead daemon when the link is lost. The player stays
+ * in the game as a statue: no heart_beat, no regeneration and no
+ * pending output.
+ */
+void
+net_dead()
+{
+  netdead = time();
+  set_heart_beat(0);
+  out_queue = ({ });
+  out_types = ({ });
+  out_bytes = 0;
+  more_source = 0;
+  paging = 0;
+  in_queue = ({ });
+  catch(save_me());
+  suspend_stats();
+  CHANNEL_D->net_dead(this_object());
+  if(environment())
+    tell_room(environment(), capitalize(real_name) +
+	      " turns into a statue.\n", ({ this_object() }));
+}
+
+void
+reconnect()
+{
+  netdead = 0;
+  resume_stats();
+  CHANNEL_D->login(this_object());
+  tell_object(this_object(), "Reconnected.\n");
+  if(environment())
+    tell_room(environment(), capitalize(real_name) +
+	      " wakes up.\n", ({ this_object() }));
+}
+
+int
+query_quitting()
+{
+  return quitting;
+}
+
+int
+query_netdead()
+{
+  return netdead;
+}
+
+static void
+drop_message(int i)
+{
+  out_bytes -= strlen(out_queue[i]);
+  out_queue = out_queue[0..i - 1] + out_queue[i + 1..sizeof(out_queue) - 1];
+  out_types = out_types[0..i - 1] + out_types[i + 1..sizeof(out_types) - 1];
+  out_dropped++;
+  out_dropped_total++;
+}
+
+/*
+ * Queue <mess>, cut to fit OUTPUT_MAX_BYTES. Returns 1 if it was queued,
+ * 0 if it was dropped.
+ */
+static int
+enqueue(string type, string mess)
+{
+  int i;
+
+  if(strlen(mess) > OUTPUT_MAX_BYTES)
+    mess = mess[0..OUTPUT_MAX_BYTES - strlen(TRUNCATED) - 1] + TRUNCATED;
+  if(out_bytes + strlen(mess) > OUTPUT_MAX_BYTES)
+  {
+    if(member_array(type, DROPPABLE) != -1)
+    {
+      out_dropped++;
+      out_dropped_total++;
+      return 0;
+    }
+    for(i = 0; i < sizeof(out_queue) &&
+	  out_bytes + strlen(mess) > OUTPUT_MAX_BYTES; )
+    {
+      if(member_array(out_types[i], DROPPABLE) != -1)
+	drop_message(i);
+      else
+	i++;
+    }
+    if(out_bytes + strlen(mess) > OUTPUT_MAX_BYTES)
+    {
+      out_dropped++;
+      out_dropped_total++;
+      return 0;
+    }
+  }
+  out_queue += ({ mess });
+  out_types += ({ type });
+  out_bytes += strlen(mess);
+  if(out_bytes > out_peak)
+    out_peak = out_bytes;
+  return 1;
+}
+
+/*
+ * Scan <str> for at most <n> newlines. Returns ({ lines, bytes }) where
+ * bytes is the length up to and including the last newline counted.
+ */
+static int *
+scan_lines(string str, int n)
+{
+  int i, len, lines;
+
+  len = strlen(str);
+  for(i = 0; i < len && lines < n; i++)
+    if(str[i] == '\n')
+      lines++;
+  return ({ lines, i });
+}
+
+/*
+ * Queue the next chunk of the active more() source, if any. Returns 1
+ * if something was queued; a chunk that had to be dropped counts as
+ * nothing.
+ */
+static int
+pull_more()
+{
+  mixed *items;
+  string text;
+  int    pos, end;
+
+  if(!more_source)
+    return 0;
+  if(!more_source[3])
+  {
+    more_source = 0;
+    return 0;
+  }
+  items = more_source[0];
+  pos = more_source[1];
+  end = pos + more_source[2];
+  if(end >= sizeof(items))
+    end = sizeof(items);
+  more_source[1] = end;
+  text = call_other(more_source[3], more_source[4], items[pos..end - 1],
+		    more_source[5]);
+  if(end >= sizeof(items))
+    more_source = 0;
+  return stringp(text) && enqueue("more", text);
+}
+
+/*
+ * Send up to PAGE_LINES lines from the head of the queue. Returns 1 if
+ * text is left over and the player has to be prompted.
+ */
+static int
+send_page()
+{
+  string  page;
+  int    *scan;
+  int     n;
+
+  page = "";
+  n = PAGE_LINES;
+  while(n > 0 && (sizeof(out_queue) || pull_more()))
+  {
+    scan = scan_lines(out_queue[0], n);
+    if(scan[0] == n && scan[1] < strlen(out_queue[0]))
+    {
+      page += out_queue[0][0..scan[1] - 1];
+      out_queue[0] = out_queue[0][scan[1]..strlen(out_queue[0]) - 1];
+      out_bytes -= scan[1];
+      break;
+    }
+    page += out_queue[0];
+    n -= scan[0];
+    out_bytes -= strlen(out_queue[0]);
+    out_queue = out_queue[1..sizeof(out_queue) - 1];
+    out_types = out_types[1..sizeof(out_types) - 1];
+  }
+  tell_object(this_object(), page);
+  if(!sizeof(out_queue) && out_dropped)
+  {
+    tell_object(this_object(), "[" + out_dropped + " message" +
+		(out_dropped == 1 ? "" : "s") + " dropped]\n");
+    out_dropped = 0;
+  }
+  return sizeof(out_queue) > 0 || more_source != 0;
+}
+
+static void
+prompt_more()
+{
+  paging = 1;
+  tell_object(this_object(), "--More-- [<return>, q] ");
+  input_to("more_input");
+}
+
+void
+more_input(string str)
+{
+  paging = 0;
+  if(str && strlen(str) && (str[0] == 'q' || str[0] == 'Q'))
+  {
+    out_queue = ({ });
+    out_types = ({ });
+    out_bytes = 0;
+    more_source = 0;
+  }
+  if(send_page())
+    prompt_more();
+}
+
+/*
+ * Messages up to PAGE_BYTES go straight to the driver unless the player
+ * is paging, so OUTPUT_MAX_BYTES only bounds the longer ones; a flood of
+ * short messages to a slow client is left to the driver's own buffer.
+ */
 void
 catch_message(string type, string mess)
 {
-  tell_object(this_object(), mess);
+  if(!interactive(this_object()))
+    return;
+  if(!paging && strlen(mess) <= PAGE_BYTES)
+  {
+    tell_object(this_object(), mess);
+    return;
+  }
+  enqueue(type, mess);
+  if(!paging && send_page())
+    prompt_more();
+}
+
+/*
+ * Page through <items>, <chunk> at a time. Each chunk is turned into
+ * text by calling <fun> in <ob> with the slice and <arg> when the pager
+ * reaches it, so long listings are never built as one string.
+ */
+void
+more(mixed *items, int chunk, object ob, string fun, mixed arg)
+{
+  if(!interactive(this_object()))
+    return;
+  more_source = ({ items, 0, chunk, ob, fun, arg });
+  if(!paging && send_page())
+    prompt_more();
+}
+
+void
+set_recording(int flag)
+{
+  if(previous_object() == find_object(REPLAY_D))
+    recording = flag;
+}
+
+mapping
+query_input_stats()
+{
+  return ([ "queued"  : sizeof(in_queue),
+	    "peak"    : in_peak,
+	    "limited" : in_limited,
+	    "dropped" : in_dropped ]);
+}
+
+mapping
+query_output_stats()
+{
+  return ([ "queued"  : sizeof(out_queue),
+	    "bytes"   : out_bytes,
+	    "peak"    : out_peak,
+	    "dropped" : out_dropped_total ]);
 }
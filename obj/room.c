@@ -0,0 +1,228 @@
+/*
+ * room.c
+ *
+ * Base class for rooms. Exits are kept in a mapping verb : destination
+ * and served by a single action, so following an exit is one mapping
+ * lookup however many exits the room has. When the first player comes
+ * in, the rooms behind the exits are loaded in the background, a few per
+ * call_out, so their compile time isn't paid on the next step.
+ *
+ * Rooms are reset by /secure/resetd, not by the driver: put the reset
+ * code in reset_room() and clone with clone_here(), which draws from
+ * /secure/poold. The first reset comes right after create(), unless the
+ * room gets its contents back from a world snapshot. Rooms nobody
+ * visited since their last reset skip it and reset when the next player
+ * walks in.
+ */
+
+#include <config.h>
+
+#define PRELOAD_PER_CALL	4
+
+static mapping exits = ([ ]);		/* verb : destination */
+static mixed  *dest_dir;		/* ({ dest, verb, ... }), built lazily */
+static string  short_desc, long_desc;
+static int     preloaded;
+static int     last_reset, visited;
+
+void
+create()
+{
+  seteuid(getuid());
+  CENSUS_D->created(this_object());
+  last_reset = time();
+  RESET_D->register(this_object());
+  call_out("first_reset", 0);
+}
+
+/*
+ * After a reboot, the contents saved in the last world snapshot come
+ * back when the room is first loaded, instead of the first reset. This
+ * runs after create() so the room is fully set up.
+ */
+void
+first_reset()
+{
+  object snap;
+
+  if(!(snap = find_object(SNAPSHOT_D)) || !snap->restore_room(this_object()))
+    reset_room();
+}
+
+/*
+ * The driver's resets come at the same time for every room; they are
+ * ignored in favour of the reset daemon's.
+ */
+void
+reset()
+{
+}
+
+void
+reset_room()
+{
+}
+
+/*
+ * For reset_room(): a clone of <prog> moved into this room, from the
+ * pool when there is one.
+ */
+static object
+clone_here(string prog)
+{
+  object ob;
+
+  ob = POOL_D->get(prog);
+  ob->move(this_object());
+  return ob;
+}
+
+void
+do_reset()
+{
+  last_reset = time();
+  visited = 0;
+  reset_room();
+}
+
+/*
+ * Called by the reset daemon. Returns 0 if the reset was skipped, which
+ * it is if nobody came by or the room was reset less than RESET_TIME
+ * ago, say by a catch-up in init().
+ */
+int
+slot_reset()
+{
+  if(!visited || last_reset + RESET_TIME > time())
+    return 0;
+  do_reset();
+  return 1;
+}
+
+void
+set_short(string str)
+{
+  short_desc = str;
+}
+
+void
+set_long(string str)
+{
+  long_desc = str;
+}
+
+string
+query_short()
+{
+  return short_desc;
+}
+
+string
+query_long()
+{
+  return long_desc;
+}
+
+void
+notify_map()
+{
+  object map;
+
+  if(map = find_object(MAP_D))
+    map->exits_changed(this_object());
+}
+
+static void
+exits_changed()
+{
+  dest_dir = 0;
+  if(find_call_out("notify_map") == -1)
+    call_out("notify_map", 0);
+}
+
+void
+add_exit(string verb, string dest)
+{
+  exits[verb] = dest;
+  exits_changed();
+}
+
+void
+remove_exit(string verb)
+{
+  exits = m_delete(exits, verb);
+  exits_changed();
+}
+
+string
+query_exit(string verb)
+{
+  return exits[verb];
+}
+
+mixed *
+query_dest_dir()
+{
+  string *verbs;
+  int     i;
+
+  if(!dest_dir)
+  {
+    verbs = m_indices(exits);
+    dest_dir = allocate(2 * sizeof(verbs));
+    for(i = 0; i < sizeof(verbs); i++)
+    {
+      dest_dir[2 * i] = exits[verbs[i]];
+      dest_dir[2 * i + 1] = verbs[i];
+    }
+  }
+  return dest_dir;
+}
+
+void
+preload_exits(int pos)
+{
+  mixed *dirs;
+  int    n;
+
+  dirs = query_dest_dir();
+  for(; pos < sizeof(dirs) && n < PRELOAD_PER_CALL; pos += 2)
+  {
+    if(!find_object(dirs[pos]))
+    {
+      catch(call_other(dirs[pos], "??"));
+      n++;
+    }
+  }
+  if(pos < sizeof(dirs))
+    call_out("preload_exits", 0, pos);
+}
+
+void
+init()
+{
+  add_action("use_exit", "", 1);
+  if(!interactive(this_player()))
+    return;
+  if(!visited && last_reset + RESET_TIME <= time())
+    RESET_D->catch_up(this_object());
+  visited = 1;
+  if(!preloaded)
+  {
+    preloaded = 1;
+    call_out("preload_exits", 0, 0);
+  }
+}
+
+int
+use_exit(string arg)
+{
+  string dest;
+
+  if(!(dest = exits[query_verb()]))
+    return 0;
+  if(this_player()->throttle_input(arg))
+    return 1;
+  this_player()->move_player(dest);
+  return 1;
+}
@@ -1,18 +1,9 @@
+inherit "/obj/room";
 
-string 
-query_short()
+void
+create()
 {
-  return "The startroom";
-}
-
-string
-query_long()
-{
-  return "You are in the startroom of Minimud.\n";
-}
-
-mixed *
-query_dest_dir()
-{
-  return ({ });
+  ::create();
+  set_short("The startroom");
+  set_long("You are in the startroom of Minimud.\n");
 }
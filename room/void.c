@@ -0,0 +1,9 @@
+inherit "/obj/room";
+
+void
+create()
+{
+  ::create();
+  set_short("The void");
+  set_long("You are floating in the void. Nothing here looks permanent.\n");
+}
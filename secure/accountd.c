@@ -0,0 +1,208 @@
+/*
+ * accountd.c
+ *
+ * Per-uid resource accounting. wizlist_info() is sampled every
+ * SAMPLE_TIME seconds and the differences to the previous sample are
+ * kept as a series of minutes: the last 60 minutes one mapping each,
+ * and the last 24 hours one mapping each, each hour being the sum of
+ * its minutes. A mapping holds uid : ({ commands, eval, heart_beats,
+ * objects }). Object counts are not in the wizlist; they are reported
+ * by whoever counts objects, through set_object_counts().
+ */
+
+#include <config.h>
+#include <wizlist.h>
+
+#define SAMPLE_TIME	60
+#define MINUTES		60
+#define HOURS		24
+#define FIELDS		({ "commands", "eval", "heart_beats", "objects" })
+
+static mapping last = ([ ]);		/* uid : ({ commands, eval, hbs }) */
+static mapping *minutes;		/* ring of MINUTES deltas */
+static mapping *hours;			/* ring of HOURS sums */
+static int      minute, hour, samples;
+static mapping  objects = ([ ]);	/* uid : object count */
+static mapping  sort_by;
+static int      sort_field;
+
+void
+create()
+{
+  seteuid(getuid());
+  minutes = allocate(MINUTES);
+  hours = allocate(HOURS);
+  call_out("sample", SAMPLE_TIME);
+}
+
+void
+set_object_counts(mapping counts)
+{
+  objects = counts;
+}
+
+static void
+add_into(mapping sum, mapping m)
+{
+  string *uids;
+  int    *a, *b;
+  int     i, j;
+
+  uids = m_indices(m);
+  for(i = 0; i < sizeof(uids); i++)
+  {
+    b = m[uids[i]];
+    if(!(a = sum[uids[i]]))
+      sum[uids[i]] = a = allocate(sizeof(b));
+    for(j = 0; j < sizeof(b); j++)
+      a[j] += b[j];
+  }
+}
+
+/*
+ * The difference of <now> to <then>. Counters that went down were reset
+ * in between, their current value is the difference.
+ */
+static int
+delta(int now, int then)
+{
+  return now >= then ? now - then : now;
+}
+
+void
+sample()
+{
+  mixed  *wl;
+  mapping d, sum;
+  int    *old;
+  string  uid;
+  int     i;
+
+  call_out("sample", SAMPLE_TIME);
+  if(catch(wl = wizlist_info()) || !wl)
+    return;
+  d = ([ ]);
+  for(i = 0; i < sizeof(wl); i++)
+  {
+    uid = wl[i][WL_NAME];
+    old = last[uid] || ({ 0, 0, 0 });
+    d[uid] = ({ delta(wl[i][WL_COMMANDS], old[0]),
+		delta(wl[i][WL_EVAL_COST], old[1]),
+		delta(wl[i][WL_HEART_BEATS], old[2]),
+		objects[uid] });
+    last[uid] = ({ wl[i][WL_COMMANDS], wl[i][WL_EVAL_COST],
+		   wl[i][WL_HEART_BEATS] });
+  }
+  if(!samples++)
+    return;		/* the first sample is the baseline */
+
+  minutes[minute] = d;
+  if(++minute == MINUTES)
+  {
+    minute = 0;
+    sum = ([ ]);
+    for(i = 0; i < MINUTES; i++)
+      if(minutes[i])
+	add_into(sum, minutes[i]);
+    hours[hour] = sum;
+    hour = (hour + 1) % HOURS;
+  }
+}
+
+/*
+ * uid : ({ commands, eval, heart_beats, objects }) over the last
+ * "minute", "hour" or "day". Objects are the latest count, not a sum.
+ * A day is the current partial hour plus the HOURS - 1 full hours
+ * before it; the oldest hour, which is overwritten next, is left out.
+ */
+mapping
+query_usage(string period)
+{
+  mapping sum;
+  string *uids;
+  int     i;
+
+  sum = ([ ]);
+  switch(period)
+  {
+  case "minute":
+    if(minutes[(minute + MINUTES - 1) % MINUTES])
+      add_into(sum, minutes[(minute + MINUTES - 1) % MINUTES]);
+    break;
+  case "hour":
+    for(i = 0; i < MINUTES; i++)
+      if(minutes[i])
+	add_into(sum, minutes[i]);
+    break;
+  case "day":
+    for(i = 0; i < HOURS; i++)
+      if(hours[i] && i != hour)
+	add_into(sum, hours[i]);
+    for(i = 0; i < minute; i++)
+      if(minutes[i])
+	add_into(sum, minutes[i]);
+    break;
+  default:
+    return 0;
+  }
+  uids = m_indices(sum);
+  for(i = 0; i < sizeof(uids); i++)
+    sum[uids[i]][3] = objects[uids[i]];
+  return sum;
+}
+
+int
+by_field(string a, string b)
+{
+  return sort_by[a][sort_field] < sort_by[b][sort_field];
+}
+
+/*
+ * The <n> uids using most of <field> over <period>, with their usage.
+ */
+mixed *
+query_top(string period, string field, int n)
+{
+  mapping usage;
+  string *uids;
+  mixed  *top;
+  int     i;
+
+  if(!(usage = query_usage(period)) ||
+     (sort_field = member_array(field, FIELDS)) == -1)
+    return 0;
+  sort_by = usage;
+  uids = sort_array(m_indices(usage), "by_field", this_object());
+  sort_by = 0;
+  if(n > 0 && sizeof(uids) > n)
+    uids = uids[0..n - 1];
+  top = allocate(sizeof(uids));
+  for(i = 0; i < sizeof(uids); i++)
+    top[i] = ({ uids[i] }) + usage[uids[i]];
+  return top;
+}
+
+mixed *
+query_snapshot()
+{
+  return ({ last, minutes, hours, minute, hour, samples });
+}
+
+void
+restore_snapshot(mixed *data)
+{
+  if(previous_object() != find_object(SNAPSHOT_D) || sizeof(data) != 6)
+    return;
+  last = data[0];
+  minutes = data[1];
+  hours = data[2];
+  minute = data[3];
+  hour = data[4];
+  samples = data[5];
+}
+
+int
+query_samples()
+{
+  return samples;
+}
@@ -0,0 +1,277 @@
+/*
+ * bench.c
+ *
+ * Micro-benchmarks. A benchmark is a function fun(int n) that performs
+ * the measured operation n times. Benchmark files in BENCH_DIR list
+ * theirs with query_benchmarks(), returning ({ ({ name, group, fun }) }),
+ * and others can be added with register().
+ *
+ * Every benchmark gets a calibrating warmup round and then a number of
+ * measured rounds, one per call_out so each round has the full eval
+ * budget. The cost of an empty loop of the same length is measured in
+ * the same round and subtracted. CPU time comes from rusage() and only
+ * has millisecond resolution, so it is reported per 1000 iterations.
+ */
+
+#include <config.h>
+
+#define DEFAULT_ITERATIONS	1000
+#define DEFAULT_ROUNDS		5
+#define EVAL_RESERVE		20000
+
+static mapping benchmarks = ([ ]);	/* name : ({ group, ob, fun }) */
+static int     loaded;
+
+static string *run_names;		/* benchmarks of the current run */
+static object  run_for;
+static int     run_index, run_round, run_rounds, run_n, iterations;
+static mapping results;			/* name : ({ n, costs, ms }) */
+
+void
+create()
+{
+  seteuid(getuid());
+}
+
+void
+register(string name, string group, object ob, string fun)
+{
+  benchmarks[name] = ({ group, ob, fun });
+}
+
+static void
+load_benchmarks()
+{
+  string *files;
+  mixed  *list;
+  string  file;
+  int     i, j;
+
+  loaded = 1;
+  files = get_dir(BENCH_DIR + "/*.c");
+  for(i = 0; i < sizeof(files); i++)
+  {
+    file = BENCH_DIR + "/" + files[i][0..strlen(files[i]) - 3];
+    if(catch(list = call_other(file, "query_benchmarks")) || !list)
+      continue;
+    for(j = 0; j < sizeof(list); j++)
+      register(list[j][0], list[j][1], find_object(file), list[j][2]);
+  }
+}
+
+mapping
+query_benchmarks()
+{
+  if(!loaded)
+    load_benchmarks();
+  return benchmarks;
+}
+
+void
+empty(int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++)
+    ;
+}
+
+static int
+cpu_ms()
+{
+  int *ru;
+
+  ru = rusage();
+  return ru[0] + ru[1];
+}
+
+static int *
+measure(object ob, string fun, int n)
+{
+  int cost, ms;
+
+  ms = cpu_ms();
+  cost = get_eval_cost();
+  if(catch(call_other(ob, fun, n)))
+    return 0;
+  cost -= get_eval_cost();
+  return ({ cost, cpu_ms() - ms });
+}
+
+static int
+isqrt(int x)
+{
+  int r, y;
+
+  if(x <= 0)
+    return 0;
+  r = x;
+  y = (r + 1) / 2;
+  while(y < r)
+  {
+    r = y;
+    y = (r + x / r) / 2;
+  }
+  return r;
+}
+
+static int *
+mean_stddev(int *arr)
+{
+  int i, sum, var;
+
+  if(!sizeof(arr))
+    return ({ 0, 0 });
+  for(i = 0; i < sizeof(arr); i++)
+    sum += arr[i];
+  sum /= sizeof(arr);
+  for(i = 0; i < sizeof(arr); i++)
+    var += (arr[i] - sum) * (arr[i] - sum);
+  return ({ sum, isqrt(var / sizeof(arr)) });
+}
+
+/*
+ * n * 100 / d, printed with two decimals.
+ */
+static string
+ratio(int n, int d)
+{
+  if(!d)
+    return "-";
+  n = n * 100 / d;
+  return sprintf("%d.%02d", n / 100, (n < 0 ? -n : n) % 100);
+}
+
+int
+by_cost(string a, string b)
+{
+  return mean_stddev(results[a][1])[0] * results[b][0] >
+    mean_stddev(results[b][1])[0] * results[a][0];
+}
+
+static string
+report()
+{
+  string *names, text;
+  int    *cost, *ms, best, n, i;
+
+  names = sort_array(m_indices(results), "by_cost", this_object());
+  text = sprintf("%-20s %8s %12s %10s %12s %8s\n", "Benchmark", "n",
+		 "eval/op", "stddev", "ms/1000 ops", "rel");
+  for(i = 0; i < sizeof(names); i++)
+  {
+    n = results[names[i]][0];
+    cost = mean_stddev(results[names[i]][1]);
+    ms = mean_stddev(results[names[i]][2]);
+    if(!i)
+      best = cost[0] * 1000 / n;
+    text += sprintf("%-20s %8d %12s %10s %12s %8s\n", names[i], n,
+		    ratio(cost[0], n), ratio(cost[1], n),
+		    ratio(ms[0] * 1000, n),
+		    best ? ratio(cost[0] * 1000 / n, best) : "-");
+  }
+  return text;
+}
+
+static void
+finish()
+{
+  if(run_for)
+    run_for->catch_message("bench", report());
+  run_names = 0;
+  results = 0;
+}
+
+/*
+ * One round of the current benchmark. Round 0 is the warmup, which also
+ * lowers the iteration count if a full round would not fit in the eval
+ * budget.
+ */
+void
+step()
+{
+  mixed *b;
+  int   *base, *r, per_op;
+
+  b = benchmarks[run_names[run_index]];
+  if(!b[1])
+  {
+    run_round = run_rounds + 1;
+  }
+  else if(!run_round)
+  {
+    run_n = iterations;
+    if(!(r = measure(b[1], b[2], run_n / 10 + 1)))
+    {
+      run_round = run_rounds + 1;
+      if(run_for)
+	run_for->catch_message("bench", run_names[run_index] + " failed.\n");
+    }
+    else
+    {
+      per_op = r[0] / (run_n / 10 + 1) + 2;
+      if(per_op * run_n * 2 > get_eval_cost() - EVAL_RESERVE)
+	run_n = (get_eval_cost() - EVAL_RESERVE) / (per_op * 2);
+      if(run_n < 1)
+	run_n = 1;
+      results[run_names[run_index]] = ({ run_n, ({ }), ({ }) });
+    }
+  }
+  else
+  {
+    base = measure(this_object(), "empty", run_n);
+    if(r = measure(b[1], b[2], run_n))
+    {
+      results[run_names[run_index]][1] += ({ r[0] - base[0] });
+      results[run_names[run_index]][2] += ({ r[1] - base[1] });
+    }
+  }
+
+  if(++run_round > run_rounds)
+  {
+    run_round = 0;
+    if(++run_index >= sizeof(run_names))
+    {
+      finish();
+      return;
+    }
+  }
+  call_out("step", 0);
+}
+
+/*
+ * Run the benchmark or group <what>. The report is sent to this_player()
+ * when all rounds are done.
+ */
+string
+run(string what, int n, int rounds)
+{
+  string *names, *all;
+  int     i;
+
+  if(run_names)
+    return "A benchmark is already running.\n";
+  if(!loaded)
+    load_benchmarks();
+  if(benchmarks[what])
+    names = ({ what });
+  else
+  {
+    names = ({ });
+    all = m_indices(benchmarks);
+    for(i = 0; i < sizeof(all); i++)
+      if(benchmarks[all[i]][0] == what)
+	names += ({ all[i] });
+  }
+  if(!sizeof(names))
+    return "No benchmark or group " + what + ".\n";
+
+  run_names = names;
+  run_for = this_player();
+  iterations = n > 0 ? n : DEFAULT_ITERATIONS;
+  run_rounds = rounds > 0 ? rounds : DEFAULT_ROUNDS;
+  run_index = run_round = 0;
+  results = ([ ]);
+  call_out("step", 0);
+  return "Running " + implode(names, ", ") + ".\n";
+}
@@ -0,0 +1,113 @@
+/*
+ * hotpaths.c
+ *
+ * Benchmarks for the paths every command goes through. Commands run in
+ * a bot parked in the void, so this_player() is the bot and nobody gets
+ * to see the output.
+ */
+
+#include <config.h>
+
+static object bot;
+
+void
+create()
+{
+  seteuid(getuid());
+}
+
+static object
+query_bot()
+{
+  if(!bot)
+  {
+    bot = clone_object(BOT_OBJ);
+    bot->start("benchbot");
+    bot->move_player(VOID);
+  }
+  return bot;
+}
+
+mixed *
+query_benchmarks()
+{
+  return ({ ({ "log_file",          "logging", "bench_log_file" }),
+	    ({ "buffered_log_file", "logging", "bench_buffered_log_file" }),
+	    ({ "command_hook",      "command", "bench_command_hook" }),
+	    ({ "command_miss",      "command", "bench_command_miss" }),
+	    ({ "say_fun",           "cmds",    "bench_say_fun" }),
+	    ({ "who_fun",           "cmds",    "bench_who_fun" }) });
+}
+
+void
+bench_log_file(int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++)
+    log_file("bench", "benchmark line\n");
+}
+
+void
+bench_buffered_log_file(int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++)
+    buffered_log_file("bench", "benchmark line\n");
+  flush_logs();
+}
+
+/*
+ * A full command: parsing, command_hook() and the who command.
+ */
+void
+bench_command_hook(int n)
+{
+  object b;
+  int    i;
+
+  b = query_bot();
+  for(i = 0; i < n; i++)
+    b->run("who");
+}
+
+/*
+ * A verb command_hook() doesn't know.
+ */
+void
+bench_command_miss(int n)
+{
+  object b;
+  int    i;
+
+  b = query_bot();
+  for(i = 0; i < n; i++)
+    b->run("xyzzy");
+}
+
+/*
+ * say_fun() needs this_player() to be the speaker, so it is called
+ * through the say command.
+ */
+void
+bench_say_fun(int n)
+{
+  object b;
+  int    i;
+
+  b = query_bot();
+  for(i = 0; i < n; i++)
+    b->run("say hello");
+}
+
+void
+bench_who_fun(int n)
+{
+  object b;
+  int    i;
+
+  b = query_bot();
+  for(i = 0; i < n; i++)
+    "/cmds/who"->who_fun(b);
+}
@@ -0,0 +1,85 @@
+/*
+ * lpc.c
+ *
+ * Benchmarks comparing ways to write the same thing in LPC.
+ */
+
+static int *data;
+
+void
+create()
+{
+  int i;
+
+  data = allocate(100);
+  for(i = 0; i < 100; i++)
+    data[i] = i;
+}
+
+mixed *
+query_benchmarks()
+{
+  return ({ ({ "map_array",    "map",  "bench_map_array" }),
+	    ({ "for_loop",     "map",  "bench_for_loop" }),
+	    ({ "local_call",   "call", "bench_local_call" }),
+	    ({ "call_other",   "call", "bench_call_other" }),
+	    ({ "closure",      "call", "bench_closure" }) });
+}
+
+int
+double_it(int x)
+{
+  return x * 2;
+}
+
+void
+bench_map_array(int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++)
+    map_array(data, "double_it", this_object());
+}
+
+void
+bench_for_loop(int n)
+{
+  int *res;
+  int  i, j;
+
+  for(i = 0; i < n; i++)
+  {
+    res = allocate(sizeof(data));
+    for(j = 0; j < sizeof(data); j++)
+      res[j] = double_it(data[j]);
+  }
+}
+
+void
+bench_local_call(int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++)
+    double_it(i);
+}
+
+void
+bench_call_other(int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++)
+    this_object()->double_it(i);
+}
+
+void
+bench_closure(int n)
+{
+  closure c;
+  int     i;
+
+  c = #'double_it;
+  for(i = 0; i < n; i++)
+    funcall(c, i);
+}
@@ -0,0 +1,317 @@
+/*
+ * census.c
+ *
+ * Live object counts per program. Objects report themselves from
+ * create() and the master reports them from prepare_destruct(). Clones
+ * are also kept by program, so objects lying around without a player
+ * near them can be found. Every program that loads is passed on to
+ * ERROR_D, which then forgets its old compile errors.
+ *
+ * Every SNAPSHOT_TIME seconds the counts are copied into a snapshot.
+ * Snapshots give the creation rates, the differences between two points
+ * in time, and the programs whose count grew in each of the last
+ * GROWTH_SNAPSHOTS snapshots, which is what a leak looks like.
+ *
+ * Looking for orphans means visiting every clone, so it runs as a
+ * background job of JOB_D, ORPHAN_SLICE clones per step.
+ */
+
+#include <config.h>
+
+#define SNAPSHOT_TIME		300
+#define MAX_SNAPSHOTS		12
+#define GROWTH_SNAPSHOTS	4
+#define ORPHAN_AGE		600
+#define ORPHAN_SLICE		200
+
+static mapping live = ([ ]);		/* program : objects alive */
+static mapping created = ([ ]);		/* program : objects ever created */
+static mapping uids = ([ ]);		/* uid : objects alive */
+static mapping clones = ([ ]);		/* program : ([ clone : time ]) */
+static mixed  *snapshots = ({ });	/* ({ time, live, created }) */
+static mapping orphans;			/* env : count, of the last scan */
+static int     orphans_time;
+static mapping scan, scan_seen;		/* the scan in progress */
+static string *scan_progs;
+static object *scan_obs;
+static int     scan_prog, scan_ob, scan_job;
+static object  scan_for;
+
+void
+create()
+{
+  seteuid(getuid());
+  call_out("snapshot", SNAPSHOT_TIME);
+}
+
+static string
+program(object ob, int clone)
+{
+  string prog;
+  int    n;
+
+  if(sscanf(file_name(ob), "%s#%d", prog, n) == 2)
+  {
+    if(clone)
+      return "/" + prog;
+    return 0;
+  }
+  return clone ? 0 : "/" + file_name(ob);
+}
+
+void
+created(object ob)
+{
+  string prog, uid;
+  object errors;
+
+  if(!ob)
+    return;
+  if(!(prog = program(ob, 1)))
+  {
+    prog = program(ob, 0);
+    if(errors = find_object(ERROR_D))
+      catch(errors->loaded(prog));
+  }
+  else
+  {
+    if(!clones[prog])
+      clones[prog] = ([ ]);
+    clones[prog][ob] = time();
+  }
+  live[prog] = live[prog] + 1;
+  created[prog] = created[prog] + 1;
+  uid = getuid(ob) || "-";
+  uids[uid] = uids[uid] + 1;
+}
+
+/*
+ * Called by the master's prepare_destruct().
+ */
+void
+destructed(object ob)
+{
+  string prog, uid;
+
+  if(!(prog = program(ob, 1)))
+    prog = program(ob, 0);
+  else if(clones[prog])
+    clones[prog] = m_delete(clones[prog], ob);
+  if(live[prog] > 0)
+    live[prog]--;
+  uid = getuid(ob) || "-";
+  if(uids[uid] > 0)
+    uids[uid]--;
+}
+
+void
+snapshot()
+{
+  object ob;
+
+  call_out("snapshot", SNAPSHOT_TIME);
+  snapshots += ({ ({ time(), copy_mapping(live), copy_mapping(created) }) });
+  if(sizeof(snapshots) > MAX_SNAPSHOTS)
+    snapshots = snapshots[1..sizeof(snapshots) - 1];
+  if(ob = find_object(ACCOUNT_D))
+    ob->set_object_counts(copy_mapping(uids));
+}
+
+mapping
+query_live()
+{
+  return live;
+}
+
+mapping
+query_uids()
+{
+  return uids;
+}
+
+/*
+ * Objects created per minute since the last snapshot.
+ */
+mapping
+query_rates()
+{
+  mapping rates, then;
+  string *progs;
+  int     secs, i;
+
+  if(!sizeof(snapshots))
+    return ([ ]);
+  then = snapshots[sizeof(snapshots) - 1][2];
+  secs = time() - snapshots[sizeof(snapshots) - 1][0];
+  if(secs < 1)
+    secs = 1;
+  rates = ([ ]);
+  progs = m_indices(created);
+  for(i = 0; i < sizeof(progs); i++)
+    if(created[progs[i]] > then[progs[i]])
+      rates[progs[i]] = (created[progs[i]] - then[progs[i]]) * 60 / secs;
+  return rates;
+}
+
+/*
+ * program : change in live count between snapshot <from> and <to>,
+ * counted back from the latest; -1 for <to> is now.
+ */
+mapping
+query_diff(int from, int to)
+{
+  mapping a, b, diff;
+  string *progs;
+  int     i;
+
+  if(from < 0 || from >= sizeof(snapshots) || to >= sizeof(snapshots))
+    return 0;
+  a = snapshots[sizeof(snapshots) - 1 - from][1];
+  b = to < 0 ? live : snapshots[sizeof(snapshots) - 1 - to][1];
+  diff = ([ ]);
+  progs = uniq_array(m_indices(a) + m_indices(b));
+  for(i = 0; i < sizeof(progs); i++)
+    if(a[progs[i]] != b[progs[i]])
+      diff[progs[i]] = b[progs[i]] - a[progs[i]];
+  return diff;
+}
+
+/*
+ * The programs whose count grew in each of the last GROWTH_SNAPSHOTS
+ * snapshots.
+ */
+string *
+query_growing()
+{
+  string *progs, *growing;
+  int     i, j, n;
+
+  n = sizeof(snapshots);
+  if(n < GROWTH_SNAPSHOTS)
+    return ({ });
+  growing = ({ });
+  progs = m_indices(snapshots[n - 1][1]);
+  for(i = 0; i < sizeof(progs); i++)
+  {
+    for(j = n - GROWTH_SNAPSHOTS + 1; j < n; j++)
+      if(snapshots[j][1][progs[i]] <= snapshots[j - 1][1][progs[i]])
+	break;
+    if(j == n)
+      growing += ({ progs[i] });
+  }
+  return growing;
+}
+
+static int
+has_player(object env)
+{
+  object ob;
+
+  for(ob = first_inventory(env); ob; ob = next_inventory(ob))
+    if(interactive(ob) || ob->query_netdead())
+      return 1;
+  return 0;
+}
+
+/*
+ * Look for clones older than ORPHAN_AGE that are not players, have no
+ * player in their environment, are not carried and are not pooled.
+ * this_player() is told when the scan is done. Returns 0 if a scan is
+ * already running.
+ */
+int
+scan_orphans()
+{
+  if(scan_job && JOB_D->query_job(scan_job))
+    return 0;
+  scan = ([ ]);
+  scan_seen = ([ ]);
+  scan_progs = m_indices(clones);
+  scan_obs = ({ });
+  scan_prog = scan_ob = 0;
+  scan_for = this_player();
+  scan_job = JOB_D->submit(this_object(), "orphan_step", 1, "maintenance",
+			   "orphan scan");
+  return scan_job;
+}
+
+static void
+check_orphan(object ob)
+{
+  string env;
+  object e;
+
+  if(!ob || clones[scan_progs[scan_prog]][ob] + ORPHAN_AGE > time() ||
+     interactive(ob) || ob->query_netdead())
+    return;
+  if(!(e = environment(ob)))
+    env = "-";
+  else if(environment(e) || e == find_object(POOL_D))
+    return;
+  else
+  {
+    env = file_name(e);
+    if(!scan_seen[env])
+      scan_seen[env] = has_player(e) ? 1 : -1;
+    if(scan_seen[env] > 0)
+      return;
+  }
+  scan[env] = scan[env] + 1;
+}
+
+mixed
+orphan_step(mixed state, int id)
+{
+  int n;
+
+  if(previous_object() != find_object(JOB_D))
+    return 0;
+  for(n = 0; n < ORPHAN_SLICE && scan_prog < sizeof(scan_progs); n++)
+  {
+    if(scan_ob >= sizeof(scan_obs))
+    {
+      scan_obs = clones[scan_progs[scan_prog]] ?
+	m_indices(clones[scan_progs[scan_prog]]) : ({ });
+      scan_ob = 0;
+    }
+    if(scan_ob < sizeof(scan_obs))
+      check_orphan(scan_obs[scan_ob++]);
+    if(scan_ob >= sizeof(scan_obs) && ++scan_prog < sizeof(scan_progs))
+      scan_obs = ({ });
+  }
+  JOB_D->progress(id, scan_prog, sizeof(scan_progs));
+  if(scan_prog < sizeof(scan_progs))
+    return 1;
+  orphans = scan;
+  orphans_time = time();
+  scan = scan_seen = 0;
+  scan_progs = 0;
+  scan_obs = 0;
+  scan_job = 0;
+  if(scan_for)
+    scan_for->catch_message("census", "The orphan scan is done.\n");
+  scan_for = 0;
+  return 0;
+}
+
+/*
+ * The result of the last orphan scan as env : count, where env is "-"
+ * for objects without environment, or 0 if none has finished.
+ */
+mapping
+query_orphans()
+{
+  return orphans;
+}
+
+int
+query_orphans_time()
+{
+  return orphans_time;
+}
+
+int
+query_snapshots()
+{
+  return sizeof(snapshots);
+}
@@ -0,0 +1,266 @@
+/*
+ * channeld.c
+ *
+ * Mud-wide channels. Every channel keeps its members as an array that is
+ * updated on login, logout, join and leave, so sending is one loop over
+ * the members. A message is formatted once; recipients are the members
+ * minus the players ignoring the speaker, which is kept as a reverse
+ * index name : ({ players ignoring name }). The last HISTORY_SIZE lines
+ * of each channel are kept in a ring buffer and replayed on join.
+ * Players whose link dies leave their channels but get them back when
+ * they reconnect. Bots are kept off the channels.
+ *
+ * Only a player itself, or a command in /cmds run by that player, may
+ * act for it. Any player can open a new channel by joining it, but
+ * names are short words a-z and there are at most MAX_CHANNELS; a
+ * channel goes away again when its last member leaves.
+ */
+
+#include <config.h>
+
+#define DEFAULT_CHANNELS	({ "chat", "newbie" })
+#define HISTORY_SIZE		20
+#define MAX_CHANNELS		32
+#define MAX_CHANNEL_NAME	12
+
+static mapping members = ([ ]);		/* channel : ({ players }) */
+static mapping history = ([ ]);		/* channel : ({ lines, next, count }) */
+static mapping ignored_by = ([ ]);	/* name : ({ players }) */
+static mapping away = ([ ]);		/* net-dead player : ({ channels }) */
+
+void
+create()
+{
+  seteuid(getuid());
+}
+
+static void
+record(string chan, string line)
+{
+  mixed *h;
+
+  if(!(h = history[chan]))
+    history[chan] = h = ({ allocate(HISTORY_SIZE), 0, 0 });
+  h[0][h[1]] = line;
+  h[1] = (h[1] + 1) % HISTORY_SIZE;
+  if(h[2] < HISTORY_SIZE)
+    h[2]++;
+}
+
+/*
+ * Whether the caller may act for <player>.
+ */
+static int
+allowed(object player)
+{
+  if(!player)
+    return 0;
+  if(previous_object() == player)
+    return 1;
+  return this_player() == player &&
+    ("/" + file_name(previous_object()))[0..5] == "/cmds/";
+}
+
+static int
+valid_channel(string chan)
+{
+  int i;
+
+  if(!strlen(chan) || strlen(chan) > MAX_CHANNEL_NAME)
+    return 0;
+  for(i = 0; i < strlen(chan); i++)
+    if(chan[i] < 'a' || chan[i] > 'z')
+      return 0;
+  return 1;
+}
+
+/*
+ * Drop <chan> once nobody is on it, unless it is a default channel.
+ */
+static void
+close_empty(string chan)
+{
+  if(!members[chan] || sizeof(members[chan]) ||
+     member_array(chan, DEFAULT_CHANNELS) != -1)
+    return;
+  members = m_delete(members, chan);
+  history = m_delete(history, chan);
+}
+
+string
+query_history(string chan)
+{
+  mixed  *h;
+  string  text;
+  int     i;
+
+  if(!(h = history[chan]))
+    return "";
+  text = "";
+  for(i = h[2]; i > 0; i--)
+    text += h[0][(h[1] - i + HISTORY_SIZE) % HISTORY_SIZE];
+  return text;
+}
+
+/*
+ * Returns 1 if <player> joined <chan>, 0 if it already was on it and -1
+ * if <chan> can't be opened.
+ */
+int
+join(object player, string chan)
+{
+  if(!allowed(player))
+    return 0;
+  if(!members[chan])
+  {
+    if(!valid_channel(chan) || sizeof(members) >= MAX_CHANNELS)
+      return -1;
+    members[chan] = ({ });
+  }
+  else if(member_array(player, members[chan]) != -1)
+    return 0;
+  members[chan] += ({ player });
+  return 1;
+}
+
+int
+leave(object player, string chan)
+{
+  if(!allowed(player) ||
+     !members[chan] || member_array(player, members[chan]) == -1)
+    return 0;
+  members[chan] -= ({ player, 0 });
+  close_empty(chan);
+  return 1;
+}
+
+void
+login(object player)
+{
+  string *ign, *chans;
+  int     i;
+
+  if(!allowed(player) || base_name(player) == BOT_OBJ)
+    return;
+  if(chans = away[player])
+    away = m_delete(away, player);
+  else
+    chans = DEFAULT_CHANNELS;
+  for(i = 0; i < sizeof(chans); i++)
+    join(player, chans[i]);
+  ign = player->query_ignoring() || ({ });
+  for(i = 0; i < sizeof(ign); i++)
+    ignored_by[ign[i]] = (ignored_by[ign[i]] || ({ })) - ({ player }) +
+      ({ player });
+}
+
+void
+logout(object player)
+{
+  string *keys;
+  int     i;
+
+  if(!allowed(player))
+    return;
+  keys = m_indices(members);
+  for(i = 0; i < sizeof(keys); i++)
+  {
+    members[keys[i]] -= ({ player, 0 });
+    close_empty(keys[i]);
+  }
+  keys = m_indices(ignored_by);
+  for(i = 0; i < sizeof(keys); i++)
+    ignored_by[keys[i]] -= ({ player, 0 });
+}
+
+/*
+ * Start or stop <player> ignoring <name>. Returns 1 if <name> is now
+ * ignored.
+ */
+int
+ignore(object player, string name)
+{
+  string *ign;
+
+  if(!allowed(player))
+    return 0;
+  ign = player->query_ignoring() || ({ });
+  if(member_array(name, ign) != -1)
+  {
+    player->set_ignoring(ign - ({ name }));
+    if(ignored_by[name])
+      ignored_by[name] -= ({ player });
+    return 0;
+  }
+  player->set_ignoring(ign + ({ name }));
+  ignored_by[name] = (ignored_by[name] || ({ })) + ({ player });
+  return 1;
+}
+
+int
+send(object player, string chan, string mess)
+{
+  object *to;
+  string  line, name;
+  int     i;
+
+  if(!allowed(player) ||
+     !members[chan] || member_array(player, members[chan]) == -1)
+    return 0;
+  name = player->query_real_name();
+  line = "[" + chan + "] " + capitalize(name) + ": " + mess + "\n";
+  record(chan, line);
+  to = members[chan];
+  if(ignored_by[name])
+    to -= ignored_by[name];
+  for(i = 0; i < sizeof(to); i++)
+    if(to[i])
+      to[i]->catch_message("channel", line);
+  return 1;
+}
+
+string *
+query_channels(object player)
+{
+  string *keys, *in;
+  int     i;
+
+  keys = m_indices(members);
+  if(!player)
+    return keys;
+  in = ({ });
+  for(i = 0; i < sizeof(keys); i++)
+    if(member_array(player, members[keys[i]]) != -1)
+      in += ({ keys[i] });
+  return in;
+}
+
+/*
+ * Like logout(), but the channels of <player> are remembered for the
+ * next login(). Memberships of statues that were reaped are dropped.
+ */
+void
+net_dead(object player)
+{
+  object *obs;
+  mapping keep;
+  int     i;
+
+  if(!allowed(player))
+    return;
+  obs = m_indices(away);
+  keep = ([ ]);
+  for(i = 0; i < sizeof(obs); i++)
+    if(objectp(obs[i]))
+      keep[obs[i]] = away[obs[i]];
+  away = keep;
+  if(base_name(player) != BOT_OBJ)
+    away[player] = query_channels(player);
+  logout(player);
+}
+
+int
+query_members(string chan)
+{
+  return members[chan] ? sizeof(members[chan] - ({ 0 })) : 0;
+}
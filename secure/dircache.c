@@ -0,0 +1,115 @@
+/*
+ * dircache.c
+ *
+ * Caches get_dir() listings per directory as ({ name, size, date })
+ * triples, fetched with a single get_dir() call. Sorted views are built
+ * on first use and kept with the listing. The master calls invalidate()
+ * from valid_write() whenever a file is written, removed or renamed.
+ */
+
+#define MAX_DIRS	64
+#define GET_DIR_ALL	7	/* names | sizes | dates */
+
+static mapping listings = ([ ]);	/* dir : ([ order : entries ]) */
+static string *lru = ({ });
+
+void
+create()
+{
+  seteuid(getuid());
+}
+
+static string
+dir_of(string path)
+{
+  int i;
+
+  for(i = strlen(path) - 1; i > 0 && path[i] != '/'; i--)
+    ;
+  return path[0..i];
+}
+
+static mixed *
+read_listing(string dir)
+{
+  mixed *raw, *entries;
+  int    i, j;
+
+  raw = get_dir(dir + "*", GET_DIR_ALL);
+  if(!raw)
+    return 0;
+  entries = allocate(sizeof(raw) / 3);
+  for(i = j = 0; j < sizeof(entries); i += 3, j++)
+    entries[j] = ({ raw[i], raw[i + 1], raw[i + 2] });
+  return entries;
+}
+
+int
+by_size(mixed *a, mixed *b)
+{
+  return a[1] < b[1];
+}
+
+int
+by_date(mixed *a, mixed *b)
+{
+  return a[2] < b[2];
+}
+
+/*
+ * Return the entries of <dir> (which must end in '/') ordered by
+ * "name", "size" or "date", or 0 if the directory can't be read. The
+ * caller gets a copy, so the cached views can't be changed from outside.
+ */
+mixed *
+query_listing(string dir, string order)
+{
+  mapping views;
+  mixed  *entries;
+  int     i;
+
+  if(views = listings[dir])
+    lru -= ({ dir });
+  else
+  {
+    if(!(entries = read_listing(dir)))
+      return 0;
+    views = ([ "name" : entries ]);
+    listings[dir] = views;
+    if(sizeof(lru) >= MAX_DIRS)
+    {
+      listings = m_delete(listings, lru[0]);
+      lru = lru[1..sizeof(lru) - 1];
+    }
+  }
+  lru += ({ dir });
+
+  if(!views[order])
+    views[order] = sort_array(views["name"], "by_" + order, this_object());
+  entries = allocate(sizeof(views[order]));
+  for(i = 0; i < sizeof(entries); i++)
+    entries[i] = views[order][i] + ({ });
+  return entries;
+}
+
+void
+invalidate(string path)
+{
+  string dir;
+
+  if(!sizeof(lru))
+    return;
+  if(path[0] != '/')
+    path = "/" + path;
+  dir = dir_of(path);
+  if(listings[dir])
+  {
+    listings = m_delete(listings, dir);
+    lru -= ({ dir });
+  }
+  if(listings[path + "/"])
+  {
+    listings = m_delete(listings, path + "/");
+    lru -= ({ path + "/" });
+  }
+}
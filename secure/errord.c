@@ -0,0 +1,261 @@
+/*
+ * errord.c
+ *
+ * Compile and runtime errors as records, ({ time, type, file, object,
+ * line, message }). The master passes every error here. The latest
+ * MAX_PER_FILE errors of every file are kept in memory, and the latest
+ * MAX_RECENT in time order for time range queries, which therefore only
+ * cover recent errors. Every record is also appended, on a line of its
+ * own, to a file per day under ERROR_DIR, so the file name is the time
+ * index. When the daemon loads, the last LOAD_BYTES of today's file are
+ * read back, and day files older than KEEP_DAYS are removed. Once a
+ * file loads cleanly its compile errors are dropped from the latest per
+ * file; the census reports every program that loads.
+ */
+
+#include <config.h>
+
+#define ERROR_DIR	"/log/errors"
+#define MAX_PER_FILE	10
+#define MAX_RECENT	1000
+#define DAY		86400
+#define LOAD_BYTES	40000
+#define KEEP_DAYS	14
+
+#define E_TIME		0
+#define E_TYPE		1
+#define E_FILE		2
+#define E_OBJECT	3
+#define E_LINE		4
+#define E_MESSAGE	5
+
+static mapping by_file = ([ ]);		/* file : ({ records }), newest last */
+static mixed  *recent = ({ });		/* records, oldest first */
+static mapping buffers = ([ ]);		/* day : records not written yet */
+static int     cut;			/* recent lacks some of today's errors */
+
+static void
+add(mixed *rec)
+{
+  mixed *recs;
+
+  recs = (by_file[rec[E_FILE]] || ({ })) + ({ rec });
+  if(sizeof(recs) > MAX_PER_FILE)
+    recs = recs[sizeof(recs) - MAX_PER_FILE..sizeof(recs) - 1];
+  by_file[rec[E_FILE]] = recs;
+  recent += ({ rec });
+  if(sizeof(recent) > MAX_RECENT)
+  {
+    recent = recent[sizeof(recent) - MAX_RECENT..sizeof(recent) - 1];
+    cut = 1;
+  }
+}
+
+/*
+ * Read back the tail of today's file. Records start on a line of their
+ * own with "a6:", so the cut-off record in front is skipped.
+ */
+static void
+load()
+{
+  string *pieces, file, str;
+  mixed  *list;
+  int     size, i, j;
+
+  file = ERROR_DIR + "/" + time() / DAY;
+  if((size = file_size(file)) <= 0)
+    return;
+  if(size > LOAD_BYTES)
+  {
+    str = read_bytes(file, size - LOAD_BYTES, LOAD_BYTES);
+    cut = 1;
+  }
+  else
+    str = read_bytes(file, 0, size);
+  pieces = explode("-\n" + (str || ""), "\na6:");
+  for(i = 1; i < sizeof(pieces); i++)
+  {
+    list = decode_data_list("a6:" + pieces[i]);
+    for(j = 0; j < sizeof(list); j++)
+      if(pointerp(list[j]) && sizeof(list[j]) == E_MESSAGE + 1)
+	add(list[j]);
+  }
+}
+
+/*
+ * Remove the day files older than KEEP_DAYS, once a day.
+ */
+void
+prune()
+{
+  string *files;
+  int     day, i;
+
+  call_out("prune", DAY);
+  files = get_dir(ERROR_DIR + "/") || ({ });
+  for(i = 0; i < sizeof(files); i++)
+    if(sscanf(files[i], "%d", day) == 1 && day < time() / DAY - KEEP_DAYS)
+      rm(ERROR_DIR + "/" + files[i]);
+}
+
+void
+create()
+{
+  seteuid(getuid());
+  if(file_size(ERROR_DIR) != -2)
+    mkdir(ERROR_DIR);
+  load();
+  prune();
+}
+
+void
+flush()
+{
+  int *days, i;
+
+  days = m_indices(buffers);
+  for(i = 0; i < sizeof(days); i++)
+    write_file(ERROR_DIR + "/" + days[i], buffers[days[i]]);
+  buffers = ([ ]);
+}
+
+/*
+ * Called by the master for every error. <type> is "compile", "runtime"
+ * or "heart_beat".
+ */
+void
+record(string type, string file, string obj, int line, string err)
+{
+  mixed *rec;
+
+  if(previous_object() != find_object(MASTER))
+    return;
+  if(file && file[0] != '/')
+    file = "/" + file;
+  rec = ({ time(), type, file || "-", obj || "-", line, err || "" });
+  add(rec);
+  if(!sizeof(buffers))
+    call_out("flush", 5);
+  buffers[rec[E_TIME] / DAY] = (buffers[rec[E_TIME] / DAY] || "") + "\n" +
+    encode_data(rec);
+}
+
+/*
+ * Called by the census when program <prog> has loaded, so whatever kept
+ * it from compiling before is fixed.
+ */
+void
+loaded(string prog)
+{
+  mixed *recs;
+  int    i;
+
+  if(previous_object() != find_object(CENSUS_D) ||
+     !(recs = by_file[prog + ".c"]))
+    return;
+  for(i = 0; i < sizeof(recs); i++)
+    if(recs[i][E_TYPE] == "compile")
+      recs[i] = 0;
+  recs -= ({ 0 });
+  if(sizeof(recs))
+    by_file[prog + ".c"] = recs;
+  else
+    by_file = m_delete(by_file, prog + ".c");
+}
+
+static int
+first_after(int t)
+{
+  int lo, hi, mid;
+
+  hi = sizeof(recent);
+  while(lo < hi)
+  {
+    mid = (lo + hi) / 2;
+    if(recent[mid][E_TIME] < t)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/*
+ * Whether <rec> is about <path> or a file under it, and its message
+ * contains <text>.
+ */
+static int
+matches(mixed *rec, string path, string text)
+{
+  if(path && path != "/" && rec[E_FILE] != path &&
+     rec[E_FILE][0..strlen(path)] != path + "/")
+    return 0;
+  if(text && strstr(rec[E_MESSAGE], text) == -1)
+    return 0;
+  return 1;
+}
+
+/*
+ * The errors in files under <path> since <from> whose message contains
+ * <text>, oldest first. Any of them may be 0. Only the last MAX_RECENT
+ * errors are searched, see query_oldest().
+ */
+mixed *
+query_errors(string path, int from, string text)
+{
+  mixed *res;
+  int    i;
+
+  res = ({ });
+  for(i = first_after(from); i < sizeof(recent); i++)
+    if(matches(recent[i], path, text))
+      res += ({ recent[i] });
+  return res;
+}
+
+/*
+ * The time from which on query_errors() finds every error: the oldest
+ * one kept, or the start of the day if nothing was left out.
+ */
+int
+query_oldest()
+{
+  if(cut && sizeof(recent))
+    return recent[0][E_TIME];
+  return time() / DAY * DAY;
+}
+
+/*
+ * The latest error of every file under <path>, newest first.
+ */
+mixed *
+query_latest(string path)
+{
+  string *files;
+  mixed  *res, *recs;
+  int     i;
+
+  files = m_indices(by_file);
+  res = ({ });
+  for(i = 0; i < sizeof(files); i++)
+  {
+    recs = by_file[files[i]];
+    if(matches(recs[sizeof(recs) - 1], path, 0))
+      res += ({ recs[sizeof(recs) - 1] });
+  }
+  return sort_array(res, "by_time", this_object());
+}
+
+mixed *
+query_file(string file)
+{
+  if(file[0] != '/')
+    file = "/" + file;
+  return by_file[file] || ({ });
+}
+
+int
+by_time(mixed *a, mixed *b)
+{
+  return a[E_TIME] < b[E_TIME];
+}
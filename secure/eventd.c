@@ -0,0 +1,190 @@
+/*
+ * eventd.c
+ *
+ * Room events for objects that ask for them. An object subscribes to
+ * events such as "enter", "leave", "say" or "fight" and is then indexed
+ * under its current room; the index follows it as it moves. Events are
+ * delivered only to subscribers in the room where they happen, as
+ *
+ *   subscriber->receive_event(string event, mixed who, mixed data)
+ *
+ * For "enter" data is the room the mover came from, for "leave" the room
+ * it went to. The master sends "destruct" once for every destructed
+ * object, with data the number of objects that went with it. When a
+ * group moves with move_group(), every subscriber gets one event per
+ * room with <who> being the array of movers.
+ *
+ * Objects moved with a raw move_object() must be reported to moved() by
+ * whoever moved them; the master and the pool do so.
+ */
+
+static mapping rooms = ([ ]);	/* room : ([ event : ({ subscribers }) ]) */
+static mapping where = ([ ]);	/* subscriber : room it is indexed under */
+static mapping batch;		/* room : ([ event : ({ movers, data }) ]) */
+
+void
+create()
+{
+  seteuid(getuid());
+}
+
+static void
+index_in(object room, object ob, string *events)
+{
+  mapping subs;
+  int     i;
+
+  if(!room || !events)
+    return;
+  if(!(subs = rooms[room]))
+    rooms[room] = subs = ([ ]);
+  for(i = 0; i < sizeof(events); i++)
+    subs[events[i]] = (subs[events[i]] ? subs[events[i]] - ({ ob, 0 }) :
+		       ({ })) + ({ ob });
+}
+
+static void
+index_out(object room, object ob, string *events)
+{
+  mapping subs;
+  int     i;
+
+  if(!room || !events || !(subs = rooms[room]))
+    return;
+  for(i = 0; i < sizeof(events); i++)
+    if(subs[events[i]])
+      subs[events[i]] -= ({ ob, 0 });
+}
+
+/*
+ * Take <ob> out of every event list of the room it is indexed under.
+ */
+static void
+drop(object ob)
+{
+  mapping subs;
+  string *evs;
+  int     i;
+
+  if(!where[ob])
+    return;
+  if(subs = rooms[where[ob]])
+  {
+    evs = m_indices(subs);
+    for(i = 0; i < sizeof(evs); i++)
+      subs[evs[i]] -= ({ ob, 0 });
+  }
+  where = m_delete(where, ob);
+}
+
+void
+subscribe(object ob, string *events)
+{
+  if(where[ob] && where[ob] != environment(ob))
+    drop(ob);
+  if(!environment(ob))
+    return;
+  index_in(environment(ob), ob, events);
+  where[ob] = environment(ob);
+}
+
+void
+unsubscribe(object ob, string *events)
+{
+  index_out(where[ob], ob, events);
+}
+
+void
+dispatch(object room, string event, mixed who, mixed data)
+{
+  mapping subs;
+  object *to;
+  int     i;
+
+  if(!room || !(subs = rooms[room]) || !(to = subs[event]))
+    return;
+  for(i = 0; i < sizeof(to); i++)
+    if(to[i] && (pointerp(who) ? member_array(to[i], who) == -1 :
+		 to[i] != who))
+      catch(to[i]->receive_event(event, who, data));
+}
+
+static void
+queue(object room, string event, object who, mixed data)
+{
+  mapping ev;
+
+  if(!room || !rooms[room] || !rooms[room][event])
+    return;
+  if(!(ev = batch[room]))
+    batch[room] = ev = ([ ]);
+  if(ev[event])
+    ev[event][0] += ({ who });
+  else
+    ev[event] = ({ ({ who }), data });
+}
+
+/*
+ * Called from move() in /obj/object after every move, and by those who
+ * move objects with move_object(). <events> are the events <ob> listens
+ * to; the index is rebuilt from them wherever it was before.
+ */
+void
+moved(object ob, object from, object to, string *events)
+{
+  drop(ob);
+  if(to && events && sizeof(events))
+  {
+    index_in(to, ob, events);
+    where[ob] = to;
+  }
+  if(batch)
+  {
+    queue(from, "leave", ob, to);
+    queue(to, "enter", ob, from);
+    return;
+  }
+  dispatch(from, "leave", ob, to);
+  dispatch(to, "enter", ob, from);
+}
+
+/*
+ * Move <obs> to <dest> and deliver the resulting events once per room.
+ * The batch is only shared with moved() while the moves run; an outer
+ * group's batch is put back afterwards.
+ */
+void
+move_group(object *obs, mixed dest)
+{
+  object *rms;
+  string *evs;
+  mapping done, outer;
+  int     i, j;
+
+  outer = batch;
+  done = batch = ([ ]);
+  for(i = 0; i < sizeof(obs); i++)
+    if(obs[i])
+      catch(obs[i]->move(dest));
+  batch = outer;
+
+  rms = m_indices(done);
+  for(i = 0; i < sizeof(rms); i++)
+  {
+    evs = m_indices(done[rms[i]]);
+    for(j = 0; j < sizeof(evs); j++)
+      dispatch(rms[i], evs[j], done[rms[i]][evs[j]][0],
+	       done[rms[i]][evs[j]][1]);
+  }
+}
+
+/*
+ * Called by the master when <ob> is destructed.
+ */
+void
+forget(object ob)
+{
+  if(rooms[ob])
+    rooms = m_delete(rooms, ob);
+  drop(ob);
+}
@@ -0,0 +1,70 @@
+/*
+ * inputd.c
+ *
+ * Runs the input lines players had queued for sending commands too fast
+ * (see throttle_input() in the player). Once a second every waiting
+ * player gets to run one line per round, round after round, until all
+ * are out of tokens or lines, so one flooding player can't starve the
+ * others.
+ */
+
+#include <config.h>
+
+#define TICK_TIME	1
+#define EVAL_RESERVE	50000
+
+static object *waiting = ({ });
+static int     lines_run;
+
+void
+create()
+{
+  seteuid(getuid());
+}
+
+void
+queued(object player)
+{
+  if(member_array(player, waiting) == -1)
+    waiting += ({ player });
+  if(find_call_out("tick") == -1)
+    call_out("tick", TICK_TIME);
+}
+
+void
+tick()
+{
+  object *round, *next;
+  int     i, left;
+
+  round = waiting - ({ 0 });
+  while(sizeof(round) && get_eval_cost() > EVAL_RESERVE)
+  {
+    next = ({ });
+    for(i = 0; i < sizeof(round) && get_eval_cost() > EVAL_RESERVE; i++)
+    {
+      if(!round[i] || catch(left = round[i]->run_queued()))
+      {
+	waiting -= ({ round[i] });
+	continue;
+      }
+      if(left < 0)
+	continue;		/* out of tokens until the next tick */
+      lines_run++;
+      if(left)
+	next += ({ round[i] });
+      else
+	waiting -= ({ round[i] });
+    }
+    round = next;
+  }
+  waiting -= ({ 0 });
+  if(sizeof(waiting))
+    call_out("tick", TICK_TIME);
+}
+
+int *
+query_stats()
+{
+  return ({ sizeof(waiting), lines_run });
+}
@@ -0,0 +1,356 @@
+/*
+ * intermud.c
+ *
+ * Intermud over the driver's IMP port, in the inetd packet format:
+ * "KEY:value|KEY:value|...|DATA:text", with DATA always last.
+ *
+ * Packets are not handled in receive_imp(). They are put in an inbox
+ * and handled a batch per call_out, within the eval budget. Each host
+ * may send HOST_BUDGET packets per BUDGET_TIME seconds, the rest are
+ * dropped unparsed. Replies go to an outbox that is sent at most
+ * SEND_PER_TICK packets per second. Muds that send us anything are
+ * kept in the directory for MUD_TTL seconds. Expired budgets and muds
+ * are pruned every BUDGET_TIME seconds.
+ *
+ * Only requests go out on behalf of others, and only for commands and
+ * the daemons in /secure; arbitrary packets are never relayed.
+ */
+
+#include <config.h>
+
+#define HOST_BUDGET	30
+#define BUDGET_TIME	60
+#define MAX_INBOX	200
+#define MAX_OUTBOX	200
+#define SEND_PER_TICK	10
+#define MUD_TTL		3600
+#define EVAL_RESERVE	20000
+
+#define REQUESTS	({ "ping", "who", "tell", "mudlist", "reply" })
+
+static mixed  *inbox = ({ });		/* ({ host, msg }) */
+static mixed  *outbox = ({ });		/* ({ host, port, msg }) */
+static mapping budgets = ([ ]);		/* host : ({ window, count }) */
+static mapping muds = ([ ]);		/* name : ({ host, port, time }) */
+static mapping stats = ([ "received" : 0, "dropped" : 0, "sent" : 0,
+			  "bad" : 0 ]);
+static mapping pending = ([ ]);		/* id : player waiting for a reply */
+static int     next_id;
+
+void
+create()
+{
+  seteuid(getuid());
+  call_out("prune", BUDGET_TIME);
+}
+
+void
+prune()
+{
+  string *keys;
+  int     i;
+
+  call_out("prune", BUDGET_TIME);
+  keys = m_indices(budgets);
+  for(i = 0; i < sizeof(keys); i++)
+    if(budgets[keys[i]][0] + BUDGET_TIME <= time())
+      budgets = m_delete(budgets, keys[i]);
+  keys = m_indices(muds);
+  for(i = 0; i < sizeof(keys); i++)
+    if(muds[keys[i]][2] + MUD_TTL <= time())
+      muds = m_delete(muds, keys[i]);
+}
+
+/*
+ * Called by the master's receive_imp().
+ */
+void
+receive(string host, string msg)
+{
+  int *b;
+
+  if(previous_object() != find_object(MASTER))
+    return;
+  stats["received"]++;
+  if(!(b = budgets[host]) || b[0] + BUDGET_TIME <= time())
+    budgets[host] = b = ({ time(), 0 });
+  if(++b[1] > HOST_BUDGET || sizeof(inbox) >= MAX_INBOX)
+  {
+    stats["dropped"]++;
+    return;
+  }
+  inbox += ({ ({ host, msg }) });
+  if(find_call_out("process") == -1)
+    call_out("process", 0);
+}
+
+static mapping
+parse(string msg)
+{
+  mapping packet;
+  string *fields;
+  string  key, val, data;
+  int     i;
+
+  packet = ([ ]);
+  if(sscanf(msg, "%s|DATA:%s", msg, data) == 2)
+    packet["DATA"] = data;
+  else if(sscanf(msg, "DATA:%s", data) == 1)
+  {
+    packet["DATA"] = data;
+    msg = "";
+  }
+  fields = explode(msg, "|");
+  for(i = 0; i < sizeof(fields); i++)
+  {
+    if(sscanf(fields[i], "%s:%s", key, val) != 2)
+      return 0;
+    packet[key] = val;
+  }
+  return packet;
+}
+
+static string
+encode(mapping packet)
+{
+  string *keys, str;
+  int     i;
+
+  str = "";
+  keys = m_indices(packet) - ({ "DATA" });
+  for(i = 0; i < sizeof(keys); i++)
+    str += keys[i] + ":" + packet[keys[i]] + "|";
+  return str + "DATA:" + (packet["DATA"] || "");
+}
+
+/*
+ * Queue <packet> for <host> <port>. Returns 0 if the outbox is full.
+ */
+static int
+send(string host, int port, mapping packet)
+{
+  if(sizeof(outbox) >= MAX_OUTBOX)
+    return 0;
+  packet["NAME"] = MUDNAME;
+  packet["UDP"] = query_imp_port() + "";
+  outbox += ({ ({ host, port, encode(packet) }) });
+  if(find_call_out("flush") == -1)
+    call_out("flush", 0);
+  return 1;
+}
+
+void
+flush()
+{
+  int i;
+
+  for(i = 0; i < sizeof(outbox) && i < SEND_PER_TICK; i++)
+    if(send_imp(outbox[i][0], outbox[i][1], outbox[i][2]))
+      stats["sent"]++;
+  outbox = outbox[i..sizeof(outbox) - 1];
+  if(sizeof(outbox))
+    call_out("flush", 1);
+}
+
+static int
+port_of(mapping packet)
+{
+  int port;
+
+  sscanf(packet["UDP"] || "", "%d", port);
+  return port;
+}
+
+static void
+reply(string host, mapping packet, string data)
+{
+  send(host, port_of(packet),
+       ([ "REQ" : "reply", "ID" : packet["ID"] || "0",
+	  "RCPNT" : packet["SND"] || "", "DATA" : data ]));
+}
+
+void
+process()
+{
+  mapping packet;
+  string  host;
+  int     i;
+
+  for(i = 0; i < sizeof(inbox) && get_eval_cost() > EVAL_RESERVE; i++)
+  {
+    host = inbox[i][0];
+    if(!(packet = parse(inbox[i][1])) || !packet["NAME"] || !packet["UDP"] ||
+       member_array(packet["REQ"], REQUESTS) == -1)
+    {
+      stats["bad"]++;
+      continue;
+    }
+    muds[lower_case(packet["NAME"])] = ({ host, port_of(packet), time() });
+    catch(handle(host, packet));
+  }
+  inbox = inbox[i..sizeof(inbox) - 1];
+  if(sizeof(inbox))
+    call_out("process", 0);
+}
+
+static void
+do_ping(string host, mapping packet)
+{
+  reply(host, packet, MUDNAME + " is alive.\n");
+}
+
+static void
+do_who(string host, mapping packet)
+{
+  object *us;
+  string  text;
+  int     i;
+
+  us = users();
+  text = "";
+  for(i = 0; i < sizeof(us); i++)
+    if(us[i]->query_real_name())
+      text += capitalize(us[i]->query_real_name()) + "\n";
+  reply(host, packet, sizeof(us) + " on " + MUDNAME + ":\n" + text);
+}
+
+static void
+do_tell(string host, mapping packet)
+{
+  object *us;
+  int     i;
+
+  us = users();
+  for(i = 0; i < sizeof(us); i++)
+    if(us[i]->query_real_name() == lower_case(packet["RCPNT"] || ""))
+    {
+      us[i]->catch_message("tell", capitalize(packet["SND"] || "someone") +
+			   "@" + packet["NAME"] + " tells you: " +
+			   packet["DATA"] + "\n");
+      return;
+    }
+  reply(host, packet, "No one called " + packet["RCPNT"] + " here.\n");
+}
+
+static void
+do_mudlist(string host, mapping packet)
+{
+  string *names, text;
+  int     i;
+
+  names = m_indices(muds);
+  text = "";
+  for(i = 0; i < sizeof(names); i++)
+    if(muds[names[i]][2] + MUD_TTL > time())
+      text += names[i] + " " + muds[names[i]][0] + " " +
+	muds[names[i]][1] + "\n";
+  reply(host, packet, text);
+}
+
+static void
+do_reply(string host, mapping packet)
+{
+  object who;
+
+  if(!(who = pending[packet["ID"]]))
+    return;
+  pending = m_delete(pending, packet["ID"]);
+  who->catch_message("tell", "[" + packet["NAME"] + "] " + packet["DATA"]);
+}
+
+/*
+ * The handlers are static, so packets only reach them from process().
+ */
+static void
+handle(string host, mapping packet)
+{
+  switch(packet["REQ"])
+  {
+  case "ping":
+    do_ping(host, packet);
+    break;
+  case "who":
+    do_who(host, packet);
+    break;
+  case "tell":
+    do_tell(host, packet);
+    break;
+  case "mudlist":
+    do_mudlist(host, packet);
+    break;
+  case "reply":
+    do_reply(host, packet);
+    break;
+  }
+}
+
+/*
+ * The address of mud <name> as ({ host, port }), or 0 if it hasn't
+ * been heard from within MUD_TTL.
+ */
+mixed *
+query_mud(string name)
+{
+  mixed *m;
+
+  if(!(m = muds[lower_case(name)]))
+    return 0;
+  if(m[2] + MUD_TTL <= time())
+  {
+    muds = m_delete(muds, lower_case(name));
+    return 0;
+  }
+  return m[0..1];
+}
+
+mapping
+query_muds()
+{
+  return muds;
+}
+
+mapping
+query_snapshot()
+{
+  return muds;
+}
+
+void
+restore_snapshot(mapping data)
+{
+  if(previous_object() == find_object(SNAPSHOT_D) && mappingp(data))
+    muds = data;
+}
+
+mapping
+query_stats()
+{
+  return stats + ([ "inbox" : sizeof(inbox), "outbox" : sizeof(outbox) ]);
+}
+
+/*
+ * Send request <req> to the mud at <host> <port> on behalf of
+ * this_player(), who gets the reply. Only commands and the daemons in
+ * /secure may ask.
+ */
+int
+request(string host, int port, string req, mapping extra)
+{
+  mapping packet;
+  string  id, prog;
+
+  prog = "/" + file_name(previous_object());
+  if(prog[0..5] != "/cmds/" && prog[0..7] != "/secure/")
+    return 0;
+  id = (++next_id) + "";
+  packet = ([ "REQ" : req, "ID" : id,
+	      "SND" : this_player()->query_real_name() ]);
+  if(extra)
+    packet += extra;
+  if(!send(host, port, packet))
+    return 0;
+  pending[id] = this_player();
+  if(sizeof(pending) > MAX_OUTBOX)
+    pending = ([ id : this_player() ]);
+  return 1;
+}
@@ -0,0 +1,217 @@
+/*
+ * jobd.c
+ *
+ * Background jobs. A job is a function fun(state, id) in some object
+ * that does a small piece of work and returns the state to continue
+ * from, or 0 when the job is done. The daemon calls steps once a
+ * second until budget eval cost is spent, so long work is spread over
+ * as many evaluations as it needs.
+ *
+ * Jobs are in one of three classes. A class only runs when the ones
+ * before it are idle or have had their turn this tick, and
+ * "maintenance" jobs get at most a MAINT_SHARE percentage of the
+ * budget. Jobs of a class take turns.
+ */
+
+#include <config.h>
+
+#define CLASSES		({ "interactive", "normal", "maintenance" })
+#define DEFAULT_BUDGET	100000
+#define MAINT_SHARE	25
+#define EVAL_RESERVE	20000
+#define TICK_TIME	1
+
+/* A job: ({ id, ob, fun, state, class, desc, owner, steps, eval,
+ *           done, total, started }) */
+#define J_ID		0
+#define J_OB		1
+#define J_FUN		2
+#define J_STATE		3
+#define J_CLASS		4
+#define J_DESC		5
+#define J_OWNER		6
+#define J_STEPS		7
+#define J_EVAL		8
+#define J_DONE		9
+#define J_TOTAL		10
+#define J_STARTED	11
+
+static mixed  *queues;			/* class : ({ jobs }) */
+static mapping jobs = ([ ]);		/* id : job */
+static int     budget = DEFAULT_BUDGET;
+static int     next_id, finished, failed;
+
+void
+create()
+{
+  seteuid(getuid());
+  queues = ({ ({ }), ({ }), ({ }) });
+}
+
+/*
+ * Start a job calling <fun> in <ob> with <state> until it returns 0.
+ * Returns the job id, or 0 if <class> is unknown.
+ */
+int
+submit(object ob, string fun, mixed state, string class, string desc)
+{
+  mixed *job;
+  int    c;
+
+  if((c = member_array(class, CLASSES)) == -1)
+    return 0;
+  job = ({ ++next_id, ob, fun, state, c, desc || fun,
+	   this_player() ? this_player()->query_real_name() : 0,
+	   0, 0, 0, 0, time() });
+  jobs[next_id] = job;
+  queues[c] += ({ job });
+  if(find_call_out("tick") == -1)
+    call_out("tick", 0);
+  return next_id;
+}
+
+/*
+ * Jobs may report how far they are.
+ */
+void
+progress(int id, int done, int total)
+{
+  mixed *job;
+
+  if(!(job = jobs[id]) || previous_object() != job[J_OB])
+    return;
+  job[J_DONE] = done;
+  job[J_TOTAL] = total;
+}
+
+static void
+remove_job(mixed *job)
+{
+  jobs = m_delete(jobs, job[J_ID]);
+  queues[job[J_CLASS]] -= ({ job });
+}
+
+/*
+ * Only admins and the object running a job may cancel it.
+ */
+int
+cancel(int id)
+{
+  mixed *job;
+
+  if(!(job = jobs[id]) || previous_object() != job[J_OB] &&
+     !MASTER->query_player_level("admin"))
+    return 0;
+  remove_job(job);
+  return 1;
+}
+
+/*
+ * Run the jobs of class <c> in turn until <limit> eval cost is spent.
+ * Returns the cost spent.
+ */
+static int
+run_class(int c, int limit)
+{
+  mixed *job;
+  string err;
+  int    start, cost;
+
+  start = get_eval_cost();
+  while(sizeof(queues[c]) && start - get_eval_cost() < limit &&
+	get_eval_cost() > EVAL_RESERVE)
+  {
+    job = queues[c][0];
+    queues[c] = queues[c][1..sizeof(queues[c]) - 1] + ({ job });
+    if(!job[J_OB])
+    {
+      remove_job(job);
+      continue;
+    }
+    cost = get_eval_cost();
+    err = catch(job[J_STATE] = call_other(job[J_OB], job[J_FUN],
+					   job[J_STATE], job[J_ID]));
+    job[J_EVAL] += cost - get_eval_cost();
+    job[J_STEPS]++;
+    if(err)
+    {
+      failed++;
+      log_file("jobs", ctime(time()) + " job " + job[J_ID] + " (" +
+	       job[J_DESC] + ") failed: " + err);
+      remove_job(job);
+    }
+    else if(!job[J_STATE])
+    {
+      finished++;
+      remove_job(job);
+    }
+  }
+  return start - get_eval_cost();
+}
+
+void
+tick()
+{
+  int left;
+
+  left = budget;
+  left -= run_class(0, left);
+  left -= run_class(1, left);
+  run_class(2, left < budget * MAINT_SHARE / 100 ?
+	    left : budget * MAINT_SHARE / 100);
+  if(sizeof(jobs))
+    call_out("tick", TICK_TIME);
+}
+
+void
+set_budget(int n)
+{
+  if(MASTER->query_player_level("admin") && n > 0)
+    budget = n;
+}
+
+int
+query_budget()
+{
+  return budget;
+}
+
+/*
+ * ({ ({ id, desc, class, owner, steps, eval, done, total, started }) })
+ */
+mixed *
+query_jobs()
+{
+  mixed *list, *job;
+  int   *ids;
+  int    i;
+
+  ids = sort_array(m_indices(jobs), "by_id", this_object());
+  list = allocate(sizeof(ids));
+  for(i = 0; i < sizeof(ids); i++)
+  {
+    job = jobs[ids[i]];
+    list[i] = ({ job[J_ID], job[J_DESC], CLASSES[job[J_CLASS]],
+		 job[J_OWNER], job[J_STEPS], job[J_EVAL], job[J_DONE],
+		 job[J_TOTAL], job[J_STARTED] });
+  }
+  return list;
+}
+
+int
+query_job(int id)
+{
+  return jobs[id] != 0;
+}
+
+int
+by_id(int a, int b)
+{
+  return a > b;
+}
+
+int *
+query_counts()
+{
+  return ({ sizeof(jobs), finished, failed });
+}
@@ -0,0 +1,238 @@
+/*
+ * loadtest.c
+ *
+ * Drives a pool of bots (BOT_OBJ) with a weighted mix of commands and
+ * measures throughput and cost. Every tick each bot gets one command.
+ * A tick is spread over several call_outs if it would use up the
+ * evaluation budget, which shows up as lower commands/sec rather than
+ * as an aborted test.
+ *
+ * Eval cost is measured per command. The driver only gives milliseconds
+ * of CPU through rusage(), so CPU time is measured per batch.
+ */
+
+#include <config.h>
+
+#define TICK		1
+#define EVAL_RESERVE	20000
+#define MAX_SAMPLES	2000
+#define MIX		({ "look", 40, "say hello there", 25, "who", 20, \
+			   "@move", 15 })
+
+static object *bots = ({ });
+static object  owner;
+static int     running, started, stop_at, duration, cursor, to_spawn;
+static int     done, ticks, batch_cpu;
+static int    *cost_samples = ({ }), *batch_samples = ({ });
+static mapping verb_stats = ([ ]);	/* verb : ({ count, cost }) */
+
+void
+create()
+{
+  seteuid(getuid());
+}
+
+static int
+cpu_ms()
+{
+  int *ru;
+
+  ru = rusage();
+  return ru[0] + ru[1];
+}
+
+/*
+ * Keep a uniform sample of at most MAX_SAMPLES values out of <n> seen.
+ */
+static int *
+sample(int *arr, int value, int n)
+{
+  int i;
+
+  if(sizeof(arr) < MAX_SAMPLES)
+    return arr + ({ value });
+  if((i = random(n)) < MAX_SAMPLES)
+    arr[i] = value;
+  return arr;
+}
+
+static string
+pick_command(object bot)
+{
+  mixed *mix, *exits;
+  int    r, i;
+
+  mix = MIX;
+  r = random(100);
+  for(i = 0; i < sizeof(mix) - 2 && r >= mix[i + 1]; i += 2)
+    r -= mix[i + 1];
+  if(mix[i] != "@move")
+    return mix[i];
+  if(!environment(bot) ||
+     !sizeof(exits = environment(bot)->query_dest_dir()))
+    return "look";
+  return exits[random(sizeof(exits) / 2) * 2 + 1];
+}
+
+static void
+run_one(object bot)
+{
+  string line, verb, rest;
+  int    cost;
+
+  line = pick_command(bot);
+  if(sscanf(line, "%s %s", verb, rest) != 2)
+    verb = line;
+  cost = get_eval_cost();
+  catch(bot->run(line));
+  cost -= get_eval_cost();
+
+  done++;
+  cost_samples = sample(cost_samples, cost, done);
+  if(!verb_stats[verb])
+    verb_stats[verb] = ({ 0, 0 });
+  verb_stats[verb][0]++;
+  verb_stats[verb][1] += cost;
+}
+
+int
+int_gt(int a, int b)
+{
+  return a > b;
+}
+
+static int
+percentile(int *sorted, int p)
+{
+  if(!sizeof(sorted))
+    return 0;
+  return sorted[(sizeof(sorted) - 1) * p / 100];
+}
+
+string
+report()
+{
+  string *verbs, text;
+  int    *costs, *batches;
+  int     secs, i;
+
+  secs = (running ? time() : stop_at) - started;
+  if(secs <= 0)
+    secs = 1;
+  costs = sort_array(cost_samples, "int_gt", this_object());
+  batches = sort_array(batch_samples, "int_gt", this_object());
+
+  text = sprintf("Bots: %d  Commands: %d  Seconds: %d  Commands/sec: %d\n",
+		 sizeof(bots), done, secs, done / secs);
+  text += sprintf("Eval cost/command  p50 %d  p90 %d  p99 %d  max %d\n",
+		  percentile(costs, 50), percentile(costs, 90),
+		  percentile(costs, 99), percentile(costs, 100));
+  text += sprintf("CPU ms/tick        p50 %d  p90 %d  p99 %d  max %d\n",
+		  percentile(batches, 50), percentile(batches, 90),
+		  percentile(batches, 99), percentile(batches, 100));
+  verbs = m_indices(verb_stats);
+  for(i = 0; i < sizeof(verbs); i++)
+    text += sprintf("  %-12s %8d commands  %8d eval/command\n", verbs[i],
+		    verb_stats[verbs[i]][0],
+		    verb_stats[verbs[i]][1] / verb_stats[verbs[i]][0]);
+  return text;
+}
+
+void
+stop()
+{
+  string text;
+  int    i;
+
+  if(!running)
+    return;
+  remove_call_out("tick");
+  remove_call_out("spawn");
+  running = 0;
+  stop_at = time();
+  text = report();
+  log_file("loadtest", ctime(time()) + "\n" + text);
+  if(owner)
+    tell_object(owner, "Load test finished.\n" + text);
+  for(i = 0; i < sizeof(bots); i++)
+    if(bots[i])
+      destruct(bots[i]);
+  bots = ({ });
+}
+
+void
+tick()
+{
+  if(!running)
+    return;
+  if(time() >= stop_at)
+  {
+    stop();
+    return;
+  }
+  if(!cursor)
+  {
+    batch_cpu = cpu_ms();
+    bots -= ({ 0 });
+  }
+  while(cursor < sizeof(bots) && get_eval_cost() > EVAL_RESERVE)
+    run_one(bots[cursor++]);
+  if(cursor < sizeof(bots))
+  {
+    call_out("tick", 0);
+    return;
+  }
+  cursor = 0;
+  ticks++;
+  batch_samples = sample(batch_samples, cpu_ms() - batch_cpu, ticks);
+  call_out("tick", TICK);
+}
+
+/*
+ * Bots are cloned over as many call_outs as it takes; the clock starts
+ * when the last one is in the game.
+ */
+void
+spawn()
+{
+  object bot;
+
+  while(to_spawn > 0 && get_eval_cost() > EVAL_RESERVE)
+  {
+    bot = clone_object(BOT_OBJ);
+    bot->start("bot" + sizeof(bots));
+    bots += ({ bot });
+    to_spawn--;
+  }
+  if(to_spawn > 0)
+  {
+    call_out("spawn", 0);
+    return;
+  }
+  started = time();
+  stop_at = started + duration;
+  call_out("tick", TICK);
+}
+
+string
+start(int n, int secs)
+{
+  if(running)
+    return "A load test is already running.\n";
+  owner = this_player();
+  running = 1;
+  to_spawn = n;
+  duration = secs;
+  cursor = done = ticks = 0;
+  cost_samples = ({ });
+  batch_samples = ({ });
+  verb_stats = ([ ]);
+  call_out("spawn", 0);
+  return "Starting " + n + " bots for " + secs + " seconds.\n";
+}
+
+int
+query_running()
+{
+  return running;
+}
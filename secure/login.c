@@ -1,10 +1,16 @@
 
 #include <config.h>
 
+#define MIN_NAME	2
+#define MAX_NAME	16
+
+static string name, new_pass;
+
 void
 create()
 {
   seteuid(ROOT_EUID);
+  CENSUS_D->created(this_object());
 }
 
 void
@@ -15,19 +21,148 @@ logon()
   input_to("get_name");
 }
 
-void
-get_name(string name)
+/*
+ * Names are used in file names, so only a-z is allowed.
+ */
+static int
+valid_name(string str)
+{
+  int i;
+
+  if(strlen(str) < MIN_NAME || strlen(str) > MAX_NAME)
+    return 0;
+  for(i = 0; i < strlen(str); i++)
+    if(str[i] < 'a' || str[i] > 'z')
+      return 0;
+  return 1;
+}
+
+/*
+ * The crypted password of admin <who>, from ADMIN_PASSWD.
+ */
+static string
+admin_password(string who)
+{
+  string *lines, user, pass;
+  int     i;
+
+  lines = explode(read_file(ADMIN_PASSWD) || "", "\n");
+  for(i = 0; i < sizeof(lines); i++)
+    if(sscanf(lines[i], "%s:%s", user, pass) == 2 && user == who)
+      return pass;
+  return 0;
+}
+
+static void
+enter(int is_admin)
 {
   object new_ob;
 
-  if(!name)
+  if(new_ob = NETDEAD_D->reconnect(name))
   {
-    write("Login: ");
-    input_to("get_name");
+    exec(new_ob, this_object());
+    new_ob->reconnect();
+    destruct(this_object());
+    return;
   }
-  name = lower_case(name);
   new_ob = clone_object(PLAYER_OBJ);
   exec(new_ob, this_object());
+  if(is_admin)
+    new_ob->set_admin();
   new_ob->enter_game(name);
   destruct(this_object());
 }
+
+void
+get_name(string str)
+{
+  if(this_player() != this_object())
+    return;
+  if(!str || !strlen(str))
+  {
+    write("Login: ");
+    input_to("get_name");
+    return;
+  }
+  str = lower_case(str);
+  if(!valid_name(str))
+  {
+    write("Names are " + MIN_NAME + " to " + MAX_NAME +
+	  " letters a-z.\nLogin: ");
+    input_to("get_name");
+    return;
+  }
+  name = str;
+  if(MASTER->query_admin(name))
+  {
+    if(!admin_password(name))
+    {
+      write("No password is set for " + name + " yet.\n" +
+	    "Choose a password: ");
+      input_to("new_password", 1);
+      return;
+    }
+    write("Password: ");
+    input_to("get_password", 1);
+    return;
+  }
+  enter(0);
+}
+
+/*
+ * First login of an admin without an entry in ADMIN_PASSWD.
+ */
+void
+new_password(string str)
+{
+  if(this_player() != this_object())
+    return;
+  write("\n");
+  if(!str || strlen(str) < 6)
+  {
+    write("Use at least 6 characters.\n");
+    destruct(this_object());
+    return;
+  }
+  new_pass = str;
+  write("Again: ");
+  input_to("confirm_password", 1);
+}
+
+void
+confirm_password(string str)
+{
+  if(this_player() != this_object())
+    return;
+  write("\n");
+  if(str != new_pass || admin_password(name))
+  {
+    write("The passwords differ.\n");
+    destruct(this_object());
+    return;
+  }
+  write_file(ADMIN_PASSWD, name + ":" + crypt(new_pass, 0) + "\n");
+  new_pass = 0;
+  log_file("admin_login", ctime(time()) + " password set for " + name +
+	   "\n");
+  enter(1);
+}
+
+void
+get_password(string str)
+{
+  string pass;
+
+  if(this_player() != this_object())
+    return;
+  write("\n");
+  if(!(pass = admin_password(name)) || !str || crypt(str, pass) != pass)
+  {
+    write("Wrong password.\n");
+    log_file("admin_login", ctime(time()) + " failed login as " + name +
+	     "\n");
+    destruct(this_object());
+    return;
+  }
+  enter(1);
+}
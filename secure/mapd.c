@@ -0,0 +1,368 @@
+/*
+ * mapd.c
+ *
+ * The world graph. Rooms are numbered as they are found and the exits of
+ * room i are kept as adj[i] = ({ ({ dest indices }), ({ verbs }) }).
+ * The graph is crawled from START through query_dest_dir() once, as a
+ * maintenance job of /secure/jobd, and rooms report later changes with
+ * exits_changed().
+ *
+ * Routes are found with A* over the unweighted graph, using distances
+ * from a few landmark rooms as lower bounds (d(v,t) >= d(L,t) - d(L,v)).
+ * Found routes are cached until any exit changes.
+ */
+
+#include <config.h>
+
+#define LANDMARKS	4
+#define MAX_ROUTES	1000
+#define CRAWL_SLICE	10	/* rooms read per job step */
+
+static string *rooms = ({ });		/* index : room file */
+static mapping index = ([ ]);		/* room file : index + 1 */
+static mixed  *adj = ({ });		/* index : ({ dests, verbs }) */
+static mixed  *landmarks;		/* ({ distance arrays }), 0 if stale */
+static mapping routes = ([ ]);		/* "from:to" : verbs */
+static string *pending = ({ });		/* rooms left to crawl */
+static int     pending_pos;
+static int     crawl_job;
+
+void
+create()
+{
+  seteuid(getuid());
+  pending = ({ START });
+  crawl();
+}
+
+static string
+room_name(mixed room)
+{
+  string name;
+  int    n;
+
+  if(objectp(room))
+    room = file_name(room);
+  if(sscanf(room, "%s#%d", name, n) == 2)
+    room = name;
+  if(sscanf(room, "%s.c", name) == 1)
+    room = name;
+  if(room[0] != '/')
+    room = "/" + room;
+  return room;
+}
+
+static int
+node(string name)
+{
+  int i;
+
+  if(i = index[name])
+    return i - 1;
+  rooms += ({ name });
+  adj += ({ ({ ({ }), ({ }) }) });
+  index[name] = sizeof(rooms);
+  pending += ({ name });
+  return sizeof(rooms) - 1;
+}
+
+static int
+same_array(mixed *a, mixed *b)
+{
+  int i;
+
+  if(sizeof(a) != sizeof(b))
+    return 0;
+  for(i = 0; i < sizeof(a); i++)
+    if(a[i] != b[i])
+      return 0;
+  return 1;
+}
+
+/*
+ * Read the exits of room <i>. Returns 1 if they differ from what we had,
+ * including exits that only swapped destinations.
+ */
+static int
+read_exits(int i)
+{
+  mixed *exits;
+  int   *dests;
+  string *verbs;
+  int    j;
+
+  if(catch(exits = call_other(rooms[i], "query_dest_dir")) ||
+     !pointerp(exits))
+    exits = ({ });
+  dests = allocate(sizeof(exits) / 2);
+  verbs = allocate(sizeof(exits) / 2);
+  for(j = 0; j < sizeof(dests); j++)
+  {
+    dests[j] = node(room_name(exits[2 * j]));
+    verbs[j] = exits[2 * j + 1];
+  }
+  if(!same_array(dests, adj[i][0]) || !same_array(verbs, adj[i][1]))
+  {
+    adj[i] = ({ dests, verbs });
+    return 1;
+  }
+  return 0;
+}
+
+static void
+changed()
+{
+  landmarks = 0;
+  routes = ([ ]);
+}
+
+static void
+crawl()
+{
+  if(!crawl_job || !JOB_D->query_job(crawl_job))
+    crawl_job = JOB_D->submit(this_object(), "crawl_step", 1, "maintenance",
+			      "map crawl");
+}
+
+mixed
+crawl_step(mixed state, int id)
+{
+  int i, n;
+
+  if(previous_object() != find_object(JOB_D))
+    return 0;
+  for(n = 0; n < CRAWL_SLICE && pending_pos < sizeof(pending); n++)
+  {
+    i = node(pending[pending_pos++]);
+    if(read_exits(i))
+      changed();
+  }
+  JOB_D->progress(id, pending_pos, sizeof(pending));
+  if(pending_pos < sizeof(pending))
+    return 1;
+  pending = ({ });
+  pending_pos = 0;
+  crawl_job = 0;
+  return 0;
+}
+
+/*
+ * Called by rooms when they are loaded or their exits change.
+ */
+void
+exits_changed(mixed room)
+{
+  int i;
+
+  i = node(room_name(room));
+  if(read_exits(i))
+    changed();
+  if(pending_pos < sizeof(pending))
+    crawl();
+}
+
+void
+room_loaded(object room)
+{
+  if(!index[room_name(room)])
+    exits_changed(room);
+}
+
+/*
+ * Distances from <src> to every room, -1 for unreachable ones.
+ */
+static int *
+bfs(int src)
+{
+  int *dist, *queue;
+  int  head, tail, v, w, i;
+
+  dist = allocate(sizeof(rooms));
+  for(i = 0; i < sizeof(dist); i++)
+    dist[i] = -1;
+  queue = allocate(sizeof(rooms));
+  dist[src] = 0;
+  queue[tail++] = src;
+  while(head < tail)
+  {
+    v = queue[head++];
+    for(i = 0; i < sizeof(adj[v][0]); i++)
+    {
+      w = adj[v][0][i];
+      if(dist[w] < 0)
+      {
+	dist[w] = dist[v] + 1;
+	queue[tail++] = w;
+      }
+    }
+  }
+  return dist;
+}
+
+/*
+ * The first landmark is START, every further one the room farthest from
+ * the landmarks chosen so far.
+ */
+static void
+update_landmarks()
+{
+  int best, far, i, j, d;
+
+  landmarks = ({ bfs(node(START)) });
+  while(sizeof(landmarks) < LANDMARKS && sizeof(landmarks) < sizeof(rooms))
+  {
+    best = -1;
+    for(i = 0; i < sizeof(rooms); i++)
+    {
+      d = -1;
+      for(j = 0; j < sizeof(landmarks); j++)
+	if(landmarks[j][i] >= 0 && (d < 0 || landmarks[j][i] < d))
+	  d = landmarks[j][i];
+      if(d > best)
+      {
+	best = d;
+	far = i;
+      }
+    }
+    if(best <= 0)
+      break;
+    landmarks += ({ bfs(far) });
+  }
+}
+
+static int
+lower_bound(int v, int t)
+{
+  int *dist, h, i;
+
+  for(i = 0; i < sizeof(landmarks); i++)
+  {
+    dist = landmarks[i];
+    if(t < sizeof(dist) && v < sizeof(dist) && dist[t] >= 0 && dist[v] >= 0
+       && dist[t] - dist[v] > h)
+      h = dist[t] - dist[v];
+  }
+  return h;
+}
+
+/*
+ * A* from <from> to <to> with a bucket queue. Returns the verbs to
+ * follow, or 0 if there is no route.
+ */
+static string *
+find_route(int from, int to)
+{
+  mapping buckets, heads;
+  int    *g, *prev, *edge, *done, *bucket;
+  string *verbs;
+  int     f, fw, maxf, v, w, i, n;
+
+  if(!landmarks)
+    update_landmarks();
+  n = sizeof(rooms);
+  g = allocate(n);
+  prev = allocate(n);
+  edge = allocate(n);
+  done = allocate(n);
+  for(i = 0; i < n; i++)
+    g[i] = -1;
+
+  g[from] = 0;
+  f = maxf = lower_bound(from, to);
+  buckets = ([ f : ({ from }) ]);
+  heads = ([ ]);			/* f : index of the next entry */
+  while(1)
+  {
+    while(!(bucket = buckets[f]) || heads[f] >= sizeof(bucket))
+      if(++f > maxf)
+	return 0;
+    v = bucket[heads[f]];
+    heads[f] = heads[f] + 1;
+    if(done[v])
+      continue;
+    done[v] = 1;
+    if(v == to)
+      break;
+    for(i = 0; i < sizeof(adj[v][0]); i++)
+    {
+      w = adj[v][0][i];
+      if(g[w] >= 0 && g[w] <= g[v] + 1)
+	continue;
+      g[w] = g[v] + 1;
+      prev[w] = v;
+      edge[w] = i;
+      fw = g[w] + lower_bound(w, to);
+      buckets[fw] = buckets[fw] ? buckets[fw] + ({ w }) : ({ w });
+      if(fw > maxf)
+	maxf = fw;
+    }
+  }
+
+  verbs = allocate(g[to]);
+  for(v = to, i = g[to] - 1; i >= 0; v = prev[v], i--)
+    verbs[i] = adj[prev[v]][1][edge[v]];
+  return verbs;
+}
+
+/*
+ * A room to route from or to: known to the map or a loaded room.
+ */
+static int
+valid_room(string name)
+{
+  object ob;
+
+  if(index[name])
+    return 1;
+  return (ob = find_object(name)) && function_exists("query_dest_dir", ob);
+}
+
+/*
+ * The verbs leading from room <from> to room <to>, or 0 if there is no
+ * known route. Rooms may be given as objects or file names, but must be
+ * loaded; unknown files are never loaded from here.
+ */
+string *
+query_route(mixed from, mixed to)
+{
+  string  a, b, key;
+  string *verbs;
+
+  a = room_name(from);
+  b = room_name(to);
+  if(!valid_room(a) || !valid_room(b))
+    return 0;
+  if(!index[a])
+    exits_changed(a);
+  if(!index[b])
+    exits_changed(b);
+  key = a + ":" + b;
+  if(verbs = routes[key])
+    return verbs;
+  if(!(verbs = find_route(index[a] - 1, index[b] - 1)))
+    return 0;
+  if(sizeof(routes) >= MAX_ROUTES)
+    routes = ([ ]);
+  routes[key] = verbs;
+  return verbs;
+}
+
+int
+query_distance(mixed from, mixed to)
+{
+  string *verbs;
+
+  if(!(verbs = query_route(from, to)))
+    return -1;
+  return sizeof(verbs);
+}
+
+int *
+query_size()
+{
+  int edges, i;
+
+  for(i = 0; i < sizeof(adj); i++)
+    edges += sizeof(adj[i][0]);
+  return ({ sizeof(rooms), edges, sizeof(routes) });
+}
@@ -1,39 +1,82 @@
 
 
 #include "/include/config.h"
+#define MASTER_INCLUDE
 #include "simul_efun.c"
 
 object connect() {
   return clone_object(LOGIN_OBJ);
 }
 
+void
+disconnect(object obj)
+{
+  string prog;
+  int    n;
+
+  if(sscanf(file_name(obj), "%s#%d", prog, n) == 2 &&
+     "/" + prog == PLAYER_OBJ && !obj->query_quitting())
+    catch(NETDEAD_D->net_dead(obj));
+}
+
+
+static int runtime_errors, compile_errors, heart_beat_errors;
+static int storing_error;	/* guards against errors in the error store */
+
+/*
+ * Pass an error on to the error store. An error raised while storing
+ * one is only logged.
+ */
+static void
+store_error(string type, string file, string obj, int line, string err)
+{
+  if(storing_error)
+    return;
+  storing_error = 1;
+  catch(ERROR_D->record(type, file, obj, line, err));
+  storing_error = 0;
+}
 
 void runtime_error (string err, string prg, string curobj, int line)
 {
   string mess;
 
+  runtime_errors++;
   mess = curobj + ":" + prg + ":" + line + "\n" + err;
   write(mess);
   log_file("runtime.err", mess);
+  store_error("runtime", prg, curobj, line, err);
 }
 
 void log_error (string file, string err)
 {
   string mess;
 
+  compile_errors++;
   mess = file + "\n" + err;
   write(mess);
   log_file("compile.err", mess);
+  store_error("compile", file, 0, 0, err);
 }
 
 mixed heart_beat_error (object culprit, string err,
                         string prg, string curobj, int line)
 {
+  heart_beat_errors++;
   log_file("heart_beat", file_name(culprit) + "\n" + err  + "\n" + prg  + 
 	   "\n" + curobj + "\n" +  line  + "\n");
+  store_error("heart_beat", prg, curobj, line, err);
   return 0;
 }
   
+mapping
+query_error_counts()
+{
+  return ([ "runtime"    : runtime_errors,
+	    "compile"    : compile_errors,
+	    "heart_beat" : heart_beat_errors ]);
+}
+
 void crash(string error)
 {
   log_file("crashes", "CRASHED on: " + ctime(time()) +
@@ -43,7 +86,24 @@ void crash(string error)
 
 int valid_seteuid(object ob, string str) { return 1; }
 
-nomask int valid_shadow(object ob) { return 1; }
+/*
+ * Only the shadows generated by the trace daemon may shadow, and never
+ * the master or the simul_efun objects.
+ */
+int
+query_allow_shadow(object victim)
+{
+  string prog;
+
+  if(!previous_object() || victim == this_object() ||
+     "/" + file_name(victim) == SIMUL_EFUN ||
+     "/" + file_name(victim) == SEFUN_SPARE)
+    return 0;
+  prog = "/" + file_name(previous_object());
+  return prog[0..strlen(TRACE_DIR)] == TRACE_DIR + "/";
+}
+
+nomask int valid_shadow(object ob) { return query_allow_shadow(ob); }
 
 string get_root_uid() { return ROOT_EUID; }
 
@@ -51,20 +111,208 @@ string get_bb_uid() { return "Backbone"; }
 
 string *define_include_dirs() { return ({ "/include/%s" }); }
 
-string get_simul_efun() 
+string *
+epilog(int eflag)
+{
+  if(eflag)
+    return 0;
+  catch(SNAPSHOT_D->boot());
+  return PRELOADS;
+}
+
+void
+preload(string file)
+{
+  string err;
+
+  if(err = catch(call_other(file, "??")))
+    log_file("sys_errors", "preload " + file + ": " + err);
+}
+
+/*
+ * The spare simul_efun object is returned as a backup. It keeps the
+ * last working simul_efuns while the main object is being recompiled,
+ * and takes over as main object if the main one doesn't load.
+ */
+mixed
+get_simul_efun() 
+{
+  string *paths, *files, err;
+  int     i;
+
+  paths = ({ });
+  files = ({ SIMUL_EFUN, SEFUN_SPARE });
+  for(i = 0; i < sizeof(files); i++)
+  {
+    if(err = catch(call_other(files[i], "gurksallad")))
+      log_file("sys_errors", "get_simul_efun: " + files[i] + ": " + err);
+    else
+      paths += ({ files[i] });
+  }
+  if(!sizeof(paths))
+  {
+    shutdown();
+    return 0;
+  }
+  return paths;
+}
+
+void
+quota_demon()
 {
-  "/secure/simul_efun"->gurksallad();
-  return "/secure/simul_efun";
+  object ob;
+
+  if(ob = find_object(POOL_D))
+    catch(ob->trim_all());
+}
+
+void
+receive_imp(string host, string msg)
+{
+  catch(INTERMUD_D->receive(host, msg));
 }
 
 int valid_socket(object calling_ob, string func, mixed *info) { return 1;  }
 
 int valid_override(string file, string name) { return 1; }
-int valid_read() { return 1; }
-int valid_write() { return 1; }
+/*
+ * Everything may be read except the admin passwords.
+ */
+int
+valid_read(string path, string euid, string fun, mixed caller)
+{
+  if(path[0] != '/')
+    path = "/" + path;
+  if(path == ADMIN_PASSWD)
+    return euid == ROOT_EUID;
+  return 1;
+}
+
+/*
+ * Everything may be written except the admin passwords, which only Root
+ * may change, and the trace shadows, which only the trace daemon writes
+ * since query_allow_shadow() trusts them.
+ */
+int
+valid_write(string path, string euid, string fun, mixed caller)
+{
+  object ob;
+
+  if(path[0] != '/')
+    path = "/" + path;
+  if(path == ADMIN_PASSWD && euid != ROOT_EUID)
+    return 0;
+  if((path == TRACE_DIR || path[0..strlen(TRACE_DIR)] == TRACE_DIR + "/") &&
+     (!objectp(caller) || "/" + file_name(caller) != TRACE_D))
+    return 0;
+  if(ob = find_object(DIR_CACHE))
+    ob->invalidate(path);
+  return 1;
+}
 
 int valid_exec (string name) { return 1; }
 
+/*
+ * Privileged efuns are allowed per operation to the objects that need
+ * them. Admins may in addition read the wizlist and the call_outs from
+ * anywhere; everything else is refused.
+ */
+
+#define ADMIN_PRIVILEGES ({ "wizlist_info", "call_out_info" })
+
+static string *
+privileged(string op)
+{
+  switch(op)
+  {
+  case "set_this_object":
+    return ({ SIMUL_EFUN, SEFUN_SPARE });
+  case "wizlist_info":
+    return ({ ACCOUNT_D, METRICS_D });
+  case "call_out_info":
+    return ({ METRICS_D });
+  case "send_imp":
+    return ({ INTERMUD_D });
+  }
+  return ({ });
+}
+
+int
+privilege_violation(string op, mixed who, mixed arg, mixed arg2)
+{
+  string prog;
+  int    n;
+
+  if(objectp(who))
+    who = file_name(who);
+  if(sscanf(who, "%s#%d", prog, n) == 2)
+    who = prog;
+  if(who[0] != '/')
+    who = "/" + who;
+  if(who == MASTER || member_array(who, privileged(op)) != -1)
+    return 1;
+  if(member_array(op, ADMIN_PRIVILEGES) != -1 && query_player_level("admin"))
+    return 1;
+  return -1;
+}
+
+int
+query_admin(string name)
+{
+  return member_array(name, ADMINS) != -1;
+}
+
+/*
+ * Admin rights belong to player objects whose login checked the admin
+ * password, not to anything that has an admin's name.
+ */
+static int
+is_admin(object ob)
+{
+  string prog;
+  int    n;
+
+  if(!ob || sscanf(file_name(ob), "%s#%d", prog, n) != 2 ||
+     "/" + prog != PLAYER_OBJ)
+    return 0;
+  return ob->query_admin();
+}
+
+int
+query_player_level(string what)
+{
+  if(!this_player())
+    return 0;
+  switch(what)
+  {
+  case "admin":
+  case "wizard":
+  case "trace":
+    return is_admin(this_player());
+  }
+  return 0;
+}
+
+/*
+ * Admins may snoop anyone but other admins. Stopping a snoop is always
+ * allowed.
+ */
+int
+valid_snoop(object snoopee, object snooper)
+{
+  if(!snooper)
+    return 1;
+  if(!query_player_level("admin"))
+    return 0;
+  return !is_admin(snoopee);
+}
+
+int
+valid_query_snoop(object obj)
+{
+  return query_player_level("admin");
+}
+
 int
 valid_hide(object who)
 { return 0; }
@@ -96,9 +344,36 @@ string domain_file()
     return "foo";
 }
 
-string creator_file() 
+/*
+ * Files under /w/<name> belong to the wizard <name>, files under
+ * /d/<domain> to the domain, /secure to root and everything else to
+ * its top directory, so the wizlist accounts per area.
+ */
+string
+get_wiz_name(string file)
 {
+  string *path;
+
+  path = explode(file, "/") - ({ "" });
+  if(sizeof(path) < 2)
+    return 0;
+  if((path[0] == "w" || path[0] == "d") && sizeof(path) > 2)
+    return path[1];
+  if(path[0] == "secure")
+    return ROOT_EUID;
+  return path[0];
+}
+
+string
+creator_file(mixed obj)
+{
+  string name;
+
+  if(objectp(obj))
+    obj = file_name(obj);
+  if(!stringp(obj) || !(name = get_wiz_name(obj)))
     return "foo";
+  return name;
 }
 
 string author_file() 
@@ -106,6 +381,147 @@ string author_file()
     return "foo";
 }
 
+/*
+ * prepare_destruct() empties the inventory of <obj> in one pass.
+ * Players, linked or not, are moved to a safe room, everything else is
+ * destructed bottom-up so the nested prepare_destruct() calls find
+ * empty inventories. Objects nested deeper than MAX_DESTRUCT_DEPTH
+ * are parked in the void instead of being walked, and destructed from
+ * there PARK_TIME seconds later, each with a fresh depth limit. Only
+ * when nothing stops the destruct is the environment notified, once.
+ */
+
+#define MAX_DESTRUCT_DEPTH 8
+#define PARK_TIME          10
+
+static int
+is_player(object ob)
+{
+  return interactive(ob) || ob->query_netdead();
+}
+
+static void
+sort_inventory(object ob, int depth, mixed *acc)
+{
+  object *inv;
+  int     i;
+
+  inv = all_inventory(ob);
+  for(i = 0; i < sizeof(inv); i++)
+  {
+    if(is_player(inv[i]))
+      acc[0] += ({ inv[i] });
+    else if(depth >= MAX_DESTRUCT_DEPTH)
+      acc[2] += ({ inv[i] });
+    else
+    {
+      acc[1] += ({ inv[i] });
+      sort_inventory(inv[i], depth + 1, acc);
+    }
+  }
+}
+
+static int
+relocate(object ob, string dest)
+{
+  object old, ev;
+
+  old = environment(ob);
+  if(is_player(ob))
+    catch(ob->move_player(dest));
+  else
+    catch(ob->move(dest));
+  if(environment(ob) == old)
+  {
+    catch(move_object(ob, dest));
+    if(environment(ob) != old && (ev = find_object(EVENT_D)))
+      catch(ev->moved(ob, old, environment(ob), ob->query_events()));
+  }
+  return environment(ob) != old;
+}
+
+/*
+ * <obj> is going for sure: take it out of the daemons' books and tell
+ * the subscribers in its environment once, with the number of objects
+ * that went with it, as a "destruct" event (see /secure/eventd).
+ */
+static void
+destructing(object obj, int n)
+{
+  object ob;
+
+  if((ob = find_object(EVENT_D)) && environment(obj))
+    catch(ob->dispatch(environment(obj), "destruct", obj, n));
+  if(ob = find_object(EVENT_D))
+    catch(ob->forget(obj));
+  if(ob = find_object(CENSUS_D))
+    catch(ob->destructed(obj));
+}
+
+/*
+ * Destruct what prepare_destruct() parked, unless it has been moved on
+ * or turned out to be a player.
+ */
+void
+sweep_parked(object *obs, object park)
+{
+  int i;
+
+  for(i = 0; i < sizeof(obs); i++)
+    if(obs[i] && environment(obs[i]) == park && !is_player(obs[i]))
+      catch(destruct(obs[i]));
+}
+
 mixed 
-prepare_destruct (object obj) { return 0; }
+prepare_destruct (object obj)
+{
+  mixed  *acc;
+  object *parked;
+  object  ob;
+  string  dest, park;
+  int     i;
+
+  if(sscanf(file_name(obj), "%s#%d", dest, i) == 2 &&
+     "/" + dest == PLAYER_OBJ && !obj->query_quitting())
+    catch(obj->save_me());
+  if(!first_inventory(obj))
+  {
+    destructing(obj, 0);
+    return 0;
+  }
+
+  acc = ({ ({ }), ({ }), ({ }) });
+  sort_inventory(obj, 0, acc);
 
+  park = ("/" + file_name(obj) == VOID) ? START : VOID;
+  dest = ("/" + file_name(obj) == START) ? park : START;
+  for(i = 0; i < sizeof(acc[0]); i++)
+  {
+    if(!relocate(acc[0][i], dest) && !relocate(acc[0][i], park))
+      return "prepare_destruct: cannot relocate " +
+	file_name(acc[0][i]) + "\n";
+  }
+
+  parked = ({ });
+  for(i = 0; i < sizeof(acc[2]); i++)
+    if(relocate(acc[2][i], park))
+      parked += ({ acc[2][i] });
+
+  for(i = sizeof(acc[1]) - 1; i >= 0; i--)
+    if(acc[1][i])
+      catch(destruct(acc[1][i]));
+
+  while(ob = first_inventory(obj))
+  {
+    if(!relocate(ob, park))
+      return "prepare_destruct: cannot empty " + file_name(obj) + "\n";
+    parked += ({ ob });
+  }
+  if(sizeof(parked))
+    call_out("sweep_parked", PARK_TIME, parked, find_object(park));
+
+  for(i = 0; i < sizeof(acc[0]); i++)
+    tell_object(acc[0][i], "The world around you dissolves and reforms.\n");
+  destructing(obj, sizeof(acc[1]) + sizeof(parked));
+  return 0;
+}
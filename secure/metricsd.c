@@ -0,0 +1,155 @@
+/*
+ * metricsd.c
+ *
+ * Metrics for external monitoring. Every METRICS_TIME seconds the
+ * current values are appended to /log/metrics, one "<time> <key>
+ * <value>" line per metric, for a scraper to tail. Nothing is done per
+ * command or per error: the numbers are read from counters that exist
+ * anyway (the wizlist, the master's error counts, the census, the log
+ * module) and turned into rates here. Other code can add its own
+ * counters with count() and gauges with set_gauge(), up to MAX_KEYS of
+ * them, named with a-z, 0-9 and _.
+ */
+
+#include <config.h>
+#include <wizlist.h>
+
+#define METRICS_TIME	30
+#define METRICS_FILE	"/log/metrics"
+#define MAX_SIZE	200000
+#define MAX_KEYS	100
+#define MAX_KEY_LEN	40
+
+static mapping counters = ([ ]);	/* key : total */
+static mapping gauges = ([ ]);		/* key : value */
+static mapping last = ([ ]);		/* key : total at the last dump */
+static int     last_time;
+
+void
+create()
+{
+  seteuid(getuid());
+  last_time = time();
+  call_out("dump", METRICS_TIME);
+}
+
+/*
+ * Keys end up in "<time> <key> <value>" lines, so they must be one word.
+ * New keys are refused once there are MAX_KEYS.
+ */
+static int
+valid_key(string key, mapping m)
+{
+  int i;
+
+  if(!stringp(key) || !strlen(key) || strlen(key) > MAX_KEY_LEN)
+    return 0;
+  for(i = 0; i < strlen(key); i++)
+    if(!(key[i] >= 'a' && key[i] <= 'z' || key[i] >= '0' && key[i] <= '9' ||
+	 key[i] == '_'))
+      return 0;
+  return member_array(key, m_indices(m)) != -1 ||
+    sizeof(counters) + sizeof(gauges) < MAX_KEYS;
+}
+
+void
+count(string key, int n)
+{
+  if(valid_key(key, counters))
+    counters[key] = counters[key] + n;
+}
+
+void
+set_gauge(string key, int value)
+{
+  if(valid_key(key, gauges))
+    gauges[key] = value;
+}
+
+/*
+ * Change of <total> per <per> seconds since the last dump.
+ */
+static int
+rate(string key, int total, int secs, int per)
+{
+  int d;
+
+  d = total - last[key];
+  if(d < 0)
+    d = total;
+  last[key] = total;
+  return d * per / secs;
+}
+
+static mapping
+collect(int secs)
+{
+  mapping m, errors, live;
+  mixed  *wl, *co;
+  string *keys;
+  int     commands, eval, hbs, objects, i;
+
+  m = ([ "users" : sizeof(users()) ]);
+  if(!catch(wl = wizlist_info()) && wl)
+  {
+    for(i = 0; i < sizeof(wl); i++)
+    {
+      commands += wl[i][WL_COMMANDS];
+      eval += wl[i][WL_EVAL_COST];
+      hbs += wl[i][WL_HEART_BEATS];
+    }
+    m["commands_per_sec"] = rate("commands", commands, secs, 1);
+    m["eval_per_sec"] = rate("eval", eval, secs, 1);
+    m["heart_beats_per_sec"] = rate("heart_beats", hbs, secs, 1);
+  }
+  if(!catch(errors = MASTER->query_error_counts()) && errors)
+  {
+    m["runtime_errors_per_min"] =
+      rate("runtime_errors", errors["runtime"], secs, 60);
+    m["compile_errors_total"] = errors["compile"];
+    m["heart_beat_errors_total"] = errors["heart_beat"];
+  }
+  if(find_object(CENSUS_D) && (live = CENSUS_D->query_live()))
+  {
+    keys = m_indices(live);
+    for(i = 0; i < sizeof(keys); i++)
+      objects += live[keys[i]];
+    m["objects"] = objects;
+  }
+  if(!catch(co = call_out_info()) && co)
+    m["call_outs"] = sizeof(co);
+  m["log_bytes_per_sec"] = rate("log_bytes", query_log_bytes() +
+				MASTER->query_log_bytes(), secs, 1);
+  keys = m_indices(counters);
+  for(i = 0; i < sizeof(keys); i++)
+    m[keys[i]] = counters[keys[i]];
+  return m + gauges;
+}
+
+void
+dump()
+{
+  mapping m;
+  string *keys, text;
+  int    *st, secs, i;
+
+  call_out("dump", METRICS_TIME);
+  secs = time() - last_time;
+  if(secs < 1)
+    secs = 1;
+  last_time = time();
+  m = collect(secs);
+  keys = sort_array(m_indices(m), "by_name", this_object());
+  text = "";
+  for(i = 0; i < sizeof(keys); i++)
+    text += last_time + " " + keys[i] + " " + m[keys[i]] + "\n";
+  if(sizeof(st = get_dir(METRICS_FILE, 2)) && st[0] > MAX_SIZE)
+    catch(rename(METRICS_FILE, METRICS_FILE + ".old"));
+  write_file(METRICS_FILE, text);
+}
+
+int
+by_name(string a, string b)
+{
+  return a > b;
+}
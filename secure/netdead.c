@@ -0,0 +1,127 @@
+/*
+ * netdead.c
+ *
+ * Keeps track of players whose link died. They stay in the game as
+ * statues until they log in again or NETDEAD_TIME has passed. When the
+ * mud is crowded, the longest idle of the players idle for more than
+ * IDLE_TIME are disconnected to free slots; they become statues like
+ * everyone else who loses the link.
+ */
+
+#include <config.h>
+
+#define NETDEAD_TIME	1800
+#define IDLE_TIME	3600
+#define IDLE_USERS	200	/* idle out only above this many users */
+#define CHECK_TIME	60
+
+static mapping statues = ([ ]);		/* name : player */
+
+void
+create()
+{
+  seteuid(getuid());
+  call_out("check", CHECK_TIME);
+}
+
+/*
+ * Only the master reports lost links and only the login object claims
+ * statues back.
+ */
+static int
+from_login()
+{
+  string prog;
+  int    n;
+
+  return sscanf(file_name(previous_object()), "%s#%d", prog, n) == 2 &&
+    "/" + prog == LOGIN_OBJ;
+}
+
+void
+net_dead(object player)
+{
+  if(previous_object() != find_object(MASTER) || player->query_quitting())
+    return;
+  statues[player->query_real_name()] = player;
+  player->net_dead();
+}
+
+object
+reconnect(string name)
+{
+  object ob;
+
+  if(!from_login())
+    return 0;
+  if(ob = statues[name])
+    statues = m_delete(statues, name);
+  return ob;
+}
+
+object *
+query_statues()
+{
+  return m_values(statues) - ({ 0 });
+}
+
+static void
+reap()
+{
+  string *names;
+  object  ob;
+  int     i;
+
+  names = m_indices(statues);
+  for(i = 0; i < sizeof(names); i++)
+  {
+    ob = statues[names[i]];
+    if(ob && time() - ob->query_netdead() < NETDEAD_TIME)
+      continue;
+    statues = m_delete(statues, names[i]);
+    if(ob)
+    {
+      catch(ob->save_me());
+      destruct(ob);
+    }
+  }
+}
+
+int
+by_idle(object a, object b)
+{
+  return query_idle(a) < query_idle(b);
+}
+
+/*
+ * Disconnect the longest idle non-admins, as many as it takes to get
+ * back to IDLE_USERS.
+ */
+static void
+idle_out()
+{
+  object *us, *idle;
+  int     i, n;
+
+  us = users();
+  if((n = sizeof(us) - IDLE_USERS) <= 0)
+    return;
+  idle = ({ });
+  for(i = 0; i < sizeof(us); i++)
+    if(query_idle(us[i]) > IDLE_TIME && !us[i]->query_admin())
+      idle += ({ us[i] });
+  idle = sort_array(idle, "by_idle", this_object());
+  for(i = 0; i < sizeof(idle) && i < n; i++)
+  {
+    tell_object(idle[i], "You have been idle too long.\n");
+    remove_interactive(idle[i]);
+  }
+}
+
+void
+check()
+{
+  call_out("check", CHECK_TIME);
+  reap();
+  idle_out();
+}
@@ -0,0 +1,173 @@
+/*
+ * poold.c
+ *
+ * Free lists of clones. Instead of destructing an object that will be
+ * cloned again soon, release() it: if its recycle() agrees to reset it
+ * to the state of a fresh clone it is parked here, and the next get()
+ * for its program hands it out again without compiling, cloning or
+ * running create(). Every program keeps at most MAX_PER_PROGRAM clones
+ * and the pool at most MAX_POOLED. Clones that sit unused for IDLE_TIME
+ * are destructed, and the master empties the pool when memory runs out.
+ */
+
+#include <config.h>
+
+#define MAX_PER_PROGRAM	20
+#define MAX_POOLED	500
+#define IDLE_TIME	600
+#define TRIM_TIME	300
+
+static mapping pool = ([ ]);		/* program : ({ clones }) */
+static mapping since = ([ ]);		/* clone : time it was released */
+static mapping stats = ([ ]);		/* program : ({ hits, misses,
+					   pooled, destructed }) */
+static int     pooled, trims;
+
+void
+create()
+{
+  seteuid(getuid());
+  call_out("trim_idle", TRIM_TIME);
+}
+
+static int *
+stats_for(string prog)
+{
+  if(!stats[prog])
+    stats[prog] = ({ 0, 0, 0, 0 });
+  return stats[prog];
+}
+
+/*
+ * A clone of <prog>, from the pool if there is one.
+ */
+object
+get(string prog)
+{
+  object *free, ob;
+
+  if(prog[0] != '/')
+    prog = "/" + prog;
+  sscanf(prog, "%s.c", prog);
+  while((free = pool[prog]) && sizeof(free))
+  {
+    ob = free[sizeof(free) - 1];
+    pool[prog] = free[0..sizeof(free) - 2];
+    if(!ob)
+      continue;
+    pooled--;
+    since = m_delete(since, ob);
+    stats_for(prog)[0]++;
+    return ob;
+  }
+  stats_for(prog)[1]++;
+  return clone_object(prog);
+}
+
+/*
+ * Give <ob> back. It is pooled if it is an empty clone, agrees to be
+ * recycled and there is room, otherwise it is destructed.
+ */
+void
+release(object ob)
+{
+  object from, ev;
+  string prog;
+  int    ok;
+
+  if(!ob)
+    return;
+  prog = base_name(ob);
+  if(prog == "/" + file_name(ob) || first_inventory(ob) ||
+     pooled >= MAX_POOLED ||
+     (pool[prog] && sizeof(pool[prog]) >= MAX_PER_PROGRAM) ||
+     catch(ok = ob->recycle()) || !ok || !ob)
+  {
+    stats_for(prog)[3]++;
+    if(ob)
+      destruct(ob);
+    return;
+  }
+  from = environment(ob);
+  move_object(ob, this_object());
+  if(ev = find_object(EVENT_D))
+    ev->moved(ob, from, this_object(), 0);
+  pool[prog] = (pool[prog] || ({ })) + ({ ob });
+  since[ob] = time();
+  pooled++;
+  stats_for(prog)[2]++;
+}
+
+/*
+ * Destruct pooled clones of <prog>, or all of them, released before
+ * <before>.
+ */
+static void
+trim(string prog, int before)
+{
+  string *progs;
+  object *free, *keep;
+  int     i, j;
+
+  progs = prog ? ({ prog }) : m_indices(pool);
+  for(i = 0; i < sizeof(progs); i++)
+  {
+    free = pool[progs[i]] || ({ });
+    keep = ({ });
+    for(j = 0; j < sizeof(free); j++)
+    {
+      if(!free[j])
+	continue;
+      if(since[free[j]] < before)
+      {
+	since = m_delete(since, free[j]);
+	destruct(free[j]);
+      }
+      else
+	keep += ({ free[j] });
+    }
+    pooled -= sizeof(free) - sizeof(keep);
+    if(sizeof(keep))
+      pool[progs[i]] = keep;
+    else
+      pool = m_delete(pool, progs[i]);
+  }
+}
+
+void
+trim_idle()
+{
+  call_out("trim_idle", TRIM_TIME);
+  trim(0, time() - IDLE_TIME);
+}
+
+/*
+ * Called by the master's quota_demon() when memory is short.
+ */
+void
+trim_all()
+{
+  trims++;
+  trim(0, time() + 1);
+}
+
+mapping
+query_stats()
+{
+  mapping m;
+  string *progs;
+  int     i;
+
+  m = ([ ]);
+  progs = m_indices(stats);
+  for(i = 0; i < sizeof(progs); i++)
+    m[progs[i]] = ({ pool[progs[i]] ? sizeof(pool[progs[i]]) : 0 }) +
+      stats[progs[i]];
+  return m;
+}
+
+int *
+query_totals()
+{
+  return ({ pooled, trims });
+}
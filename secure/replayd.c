@@ -0,0 +1,368 @@
+/*
+ * replayd.c
+ *
+ * Session recording and replay. While recording, every input line of
+ * every player is written to SESSION_DIR/<start time> as
+ * "<seconds since start>\t<player>\t<line>". Before the first line of a
+ * player the room they are in is written as
+ * "<seconds since start>\t@<player>\t<room>". Replaying a session drives
+ * one bot per recorded player from that room with the same lines at the
+ * original pace or <speed> times faster, and keeps the eval cost and the
+ * lag behind schedule per verb, the latter measured in milliseconds with
+ * utime(). The result is saved as SESSION_DIR/<tag>.report, so two runs,
+ * e.g. before and after a change to the lib, can be compared.
+ *
+ * Recording and replaying are started and stopped by /cmds/replay only,
+ * and only players and bots record their own lines.
+ *
+ * Recordings are buffered here rather than with buffered_log_file(),
+ * which rotates files that grow large.
+ */
+
+#include <config.h>
+
+#define FLUSH_TIME	5
+#define FLUSH_BYTES	4096
+#define READ_LINES	200
+#define EVAL_RESERVE	30000
+#define REPLAY_CMD	"/cmds/replay"
+
+/* Per verb: ({ commands, eval, lag in ms }) */
+
+static string  rec_file, rec_buf;
+static int     rec_start;
+static mapping rec_seen;		/* players whose room is recorded */
+
+static string  rp_file, rp_tag;
+static object  rp_owner;
+static mapping rp_bots;			/* recorded name : bot */
+static mixed  *rp_buf;			/* ({ offset, name, line }) */
+static int     rp_pos, rp_line, rp_start, rp_speed, rp_eof;
+static int    *rp_ustart;		/* utime() at rp_start */
+static mapping rp_stats;		/* verb : ({ count, eval, lag }) */
+
+void
+create()
+{
+  seteuid(getuid());
+  if(file_size(SESSION_DIR) != -2)
+    mkdir(SESSION_DIR);
+}
+
+/*
+ * Whether the caller is the replay command.
+ */
+static int
+from_command()
+{
+  return "/" + file_name(previous_object()) == REPLAY_CMD;
+}
+
+/*
+ * Recording
+ */
+
+int
+query_recording()
+{
+  return rec_file != 0;
+}
+
+void
+flush()
+{
+  remove_call_out("flush");
+  if(rec_file && strlen(rec_buf))
+    write_file(rec_file, rec_buf);
+  rec_buf = "";
+}
+
+/*
+ * Called by players for every input line while recording.
+ */
+void
+record(string name, string line)
+{
+  object env;
+  string prog;
+  int    n;
+
+  if(!rec_file ||
+     sscanf(file_name(previous_object()), "%s#%d", prog, n) != 2 ||
+     ("/" + prog != PLAYER_OBJ && "/" + prog != BOT_OBJ) ||
+     previous_object()->query_real_name() != name)
+    return;
+  if(!strlen(rec_buf))
+    call_out("flush", FLUSH_TIME);
+  if(!rec_seen[name])
+  {
+    rec_seen[name] = 1;
+    if(env = environment(previous_object()))
+      rec_buf += (time() - rec_start) + "\t@" + name + "\t" +
+	file_name(env) + "\n";
+  }
+  rec_buf += (time() - rec_start) + "\t" + name + "\t" + line + "\n";
+  if(strlen(rec_buf) > FLUSH_BYTES)
+    flush();
+}
+
+/*
+ * Tell every player, statues included, whether to record.
+ */
+static void
+set_recording(int flag)
+{
+  object *us;
+  object  ob;
+  int     i;
+
+  us = users();
+  if(ob = find_object(NETDEAD_D))
+    us += ob->query_statues();
+  for(i = 0; i < sizeof(us); i++)
+    catch(us[i]->set_recording(flag));
+}
+
+string
+start_recording()
+{
+  if(!from_command())
+    return 0;
+  if(rec_file)
+    return "Already recording to " + rec_file + ".\n";
+  rec_start = time();
+  rec_file = SESSION_DIR + "/" + rec_start;
+  rec_buf = "";
+  rec_seen = ([ ]);
+  set_recording(1);
+  return "Recording to " + rec_file + ".\n";
+}
+
+string
+stop_recording()
+{
+  string file;
+
+  if(!from_command())
+    return 0;
+  if(!rec_file)
+    return "Not recording.\n";
+  set_recording(0);
+  flush();
+  file = rec_file;
+  rec_file = 0;
+  rec_seen = 0;
+  return "Recorded " + file + ".\n";
+}
+
+/*
+ * Replay
+ */
+
+static void
+read_more()
+{
+  string *lines, name, line;
+  int     offset, i;
+
+  rp_buf = rp_buf[rp_pos..sizeof(rp_buf) - 1];
+  rp_pos = 0;
+  if(rp_eof || !(line = read_file(rp_file, rp_line, READ_LINES)))
+  {
+    rp_eof = 1;
+    return;
+  }
+  lines = explode(line, "\n");
+  rp_line += sizeof(lines);
+  if(sizeof(lines) < READ_LINES)
+    rp_eof = 1;
+  for(i = 0; i < sizeof(lines); i++)
+    if(sscanf(lines[i], "%d\t%s\t%s", offset, name, line) == 3)
+      rp_buf += ({ ({ offset, name, line }) });
+}
+
+static object
+bot_for(string name)
+{
+  object bot;
+
+  if(!(bot = rp_bots[name]))
+  {
+    bot = clone_object(BOT_OBJ);
+    bot->start("r-" + name);
+    rp_bots[name] = bot;
+  }
+  return bot;
+}
+
+/*
+ * Milliseconds since the replay started, in recorded time.
+ */
+static int
+replay_ms()
+{
+  int *now;
+
+  now = utime();
+  return ((now[0] - rp_ustart[0]) * 1000 +
+	  (now[1] - rp_ustart[1]) / 1000) * rp_speed;
+}
+
+static void
+run_entry(mixed *e)
+{
+  string verb, rest;
+  mixed *s;
+  int    cost, late;
+
+  if(e[1][0] == '@')
+  {
+    catch(bot_for(e[1][1..strlen(e[1]) - 1])->move_player("/" + e[2]));
+    return;
+  }
+  if(sscanf(e[2], "%s %s", verb, rest) != 2)
+    verb = e[2];
+  late = (replay_ms() - e[0] * 1000) / rp_speed;
+  cost = get_eval_cost();
+  catch(bot_for(e[1])->run(e[2]));
+  cost -= get_eval_cost();
+  if(!(s = rp_stats[verb]))
+    rp_stats[verb] = s = ({ 0, 0, 0 });
+  s[0]++;
+  s[1] += cost;
+  s[2] += late > 0 ? late : 0;
+}
+
+static void
+finish()
+{
+  string *names;
+  string  report;
+  int     i;
+
+  remove_call_out("tick");
+  report = SESSION_DIR + "/" + rp_tag + ".report";
+  rm(report);
+  write_file(report, encode_data(rp_stats));
+  names = m_indices(rp_bots);
+  for(i = 0; i < sizeof(names); i++)
+    if(rp_bots[names[i]])
+      destruct(rp_bots[names[i]]);
+  if(rp_owner)
+    rp_owner->catch_message("replay", "Replay of " + rp_file +
+			    " finished, saved as " + rp_tag + ".\n");
+  rp_file = 0;
+  rp_bots = 0;
+  rp_buf = 0;
+}
+
+void
+tick()
+{
+  int clock;
+
+  clock = (time() - rp_start) * rp_speed;
+  while(get_eval_cost() > EVAL_RESERVE)
+  {
+    if(rp_pos >= sizeof(rp_buf))
+    {
+      read_more();
+      if(!sizeof(rp_buf))
+      {
+	finish();
+	return;
+      }
+    }
+    if(rp_buf[rp_pos][0] > clock)
+      break;
+    run_entry(rp_buf[rp_pos++]);
+  }
+  call_out("tick", get_eval_cost() > EVAL_RESERVE ? 1 : 0);
+}
+
+string
+replay(string session, int speed, string tag)
+{
+  if(!from_command())
+    return 0;
+  if(rp_file)
+    return "A replay is already running.\n";
+  if(file_size(SESSION_DIR + "/" + session) <= 0)
+    return "No such session: " + session + "\n";
+  rp_file = SESSION_DIR + "/" + session;
+  rp_tag = tag || session + "-" + time();
+  rp_speed = speed > 0 ? speed : 1;
+  rp_owner = this_player();
+  rp_bots = ([ ]);
+  rp_buf = ({ });
+  rp_stats = ([ ]);
+  rp_pos = rp_eof = 0;
+  rp_line = 1;
+  rp_start = time();
+  rp_ustart = utime();
+  call_out("tick", 0);
+  return "Replaying " + rp_file + " at " + rp_speed + "x as " + rp_tag +
+    ".\n";
+}
+
+string
+stop_replay()
+{
+  if(!from_command())
+    return 0;
+  if(!rp_file)
+    return "No replay is running.\n";
+  finish();
+  return "Ok\n";
+}
+
+static mapping
+load_report(string tag)
+{
+  return decode_data(read_file(SESSION_DIR + "/" + tag + ".report"));
+}
+
+/*
+ * Compare the reports <a> and <b> per verb.
+ */
+string
+compare(string a, string b)
+{
+  mapping ra, rb;
+  string *verbs, text;
+  mixed  *sa, *sb;
+  int     ea, eb, i;
+
+  if(!(ra = load_report(a)))
+    return "No report " + a + ".\n";
+  if(!(rb = load_report(b)))
+    return "No report " + b + ".\n";
+  verbs = uniq_array(m_indices(ra) + m_indices(rb));
+  text = sprintf("%-12s %8s %10s %10s %7s %8s %8s\n", "Verb", "Commands",
+		 "eval " + a[0..5], "eval " + b[0..5], "Change", "lag ms",
+		 "lag ms");
+  for(i = 0; i < sizeof(verbs); i++)
+  {
+    sa = ra[verbs[i]] || ({ 0, 0, 0 });
+    sb = rb[verbs[i]] || ({ 0, 0, 0 });
+    ea = sa[0] ? sa[1] / sa[0] : 0;
+    eb = sb[0] ? sb[1] / sb[0] : 0;
+    text += sprintf("%-12s %8d %10d %10d %6s%% %8d %8d\n", verbs[i],
+		    sa[0] > sb[0] ? sa[0] : sb[0], ea, eb,
+		    ea ? ((eb - ea) * 100 / ea) + "" : "-",
+		    sa[0] ? sa[2] / sa[0] : 0, sb[0] ? sb[2] / sb[0] : 0);
+  }
+  return text;
+}
+
+string
+query_status()
+{
+  string text;
+
+  text = rec_file ? "Recording to " + rec_file + ".\n" : "Not recording.\n";
+  if(rp_file)
+    text += "Replaying " + rp_file + " as " + rp_tag + ", " +
+      (time() - rp_start) * rp_speed + " seconds in.\n";
+  return text;
+}
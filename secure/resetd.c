@@ -0,0 +1,150 @@
+/*
+ * resetd.c
+ *
+ * Room resets, spread over RESET_TIME. Every room is hashed by file name
+ * into one of SLOTS slots and one slot is handled every RESET_TIME /
+ * SLOTS seconds, so the rooms don't all reset in the same second. Rooms
+ * nobody visited since their last reset are skipped; they catch up when
+ * a player walks in (see /obj/room). The eval cost of every slot is
+ * kept so the spread can be checked.
+ */
+
+#include <config.h>
+
+#define SLOTS		60
+#define EVAL_RESERVE	20000
+
+/* Per slot: ({ rooms, resets, skipped, last eval, max eval }) */
+#define SL_ROOMS	0
+#define SL_RESETS	1
+#define SL_SKIPPED	2
+#define SL_EVAL		3
+#define SL_MAX		4
+
+static mixed *slots;
+static int    current, pos, slot_eval;
+static int    catch_ups, catch_up_eval;
+
+void
+create()
+{
+  int i;
+
+  seteuid(getuid());
+  slots = allocate(SLOTS);
+  for(i = 0; i < SLOTS; i++)
+    slots[i] = ({ ({ }), 0, 0, 0, 0 });
+  call_out("tick", RESET_TIME / SLOTS);
+}
+
+static int
+hash(string str)
+{
+  int h, i;
+
+  for(i = 0; i < strlen(str); i++)
+    h = (h * 31 + str[i]) & 0xffffff;
+  return h % SLOTS;
+}
+
+void
+register(object room)
+{
+  mixed *slot;
+
+  slot = slots[hash(file_name(room))];
+  if(member_array(room, slot[SL_ROOMS]) == -1)
+    slot[SL_ROOMS] += ({ room });
+}
+
+/*
+ * Reset the rooms of the current slot, continuing in a new call_out if
+ * the eval budget runs low.
+ */
+void
+tick()
+{
+  mixed  *slot;
+  object  room;
+  int     cost, done;
+
+  slot = slots[current];
+  if(!pos)
+  {
+    slot[SL_ROOMS] -= ({ 0 });
+    slot_eval = 0;
+  }
+  cost = get_eval_cost();
+  while(pos < sizeof(slot[SL_ROOMS]) && get_eval_cost() > EVAL_RESERVE)
+  {
+    room = slot[SL_ROOMS][pos++];
+    if(!room || catch(done = room->slot_reset()))
+      continue;
+    if(done)
+      slot[SL_RESETS]++;
+    else
+      slot[SL_SKIPPED]++;
+  }
+  slot_eval += cost - get_eval_cost();
+  if(pos < sizeof(slot[SL_ROOMS]))
+  {
+    call_out("tick", 0);
+    return;
+  }
+  slot[SL_EVAL] = slot_eval;
+  if(slot_eval > slot[SL_MAX])
+    slot[SL_MAX] = slot_eval;
+  pos = 0;
+  current = (current + 1) % SLOTS;
+  call_out("tick", RESET_TIME / SLOTS);
+}
+
+/*
+ * Called by rooms that are entered while overdue.
+ */
+void
+catch_up(object room)
+{
+  int cost;
+
+  cost = get_eval_cost();
+  catch(room->do_reset());
+  catch_up_eval += cost - get_eval_cost();
+  catch_ups++;
+}
+
+mixed *
+query_slots()
+{
+  mixed *list;
+  int    i;
+
+  list = allocate(SLOTS);
+  for(i = 0; i < SLOTS; i++)
+    list[i] = ({ sizeof(slots[i][SL_ROOMS]) }) + slots[i][1..SL_MAX];
+  return list;
+}
+
+object *
+query_rooms()
+{
+  object *rooms;
+  int     i;
+
+  rooms = ({ });
+  for(i = 0; i < SLOTS; i++)
+    rooms += slots[i][SL_ROOMS] - ({ 0 });
+  return rooms;
+}
+
+int *
+query_catch_ups()
+{
+  return ({ catch_ups, catch_up_eval });
+}
+
+int
+query_current()
+{
+  return current;
+}
@@ -0,0 +1,140 @@
+/*
+ * codec.c
+ *
+ * A compact encoding of LPC values for save files. Every value is a
+ * type letter followed by its data:
+ *
+ *   i<n>;            integer
+ *   s<len>:<text>    string, length prefixed so no quoting is needed
+ *   a<n>:<values>    array of n values
+ *   m<n>:<pairs>     mapping of n key/value pairs
+ *
+ * Objects, closures and floats are saved as the integer 0.
+ */
+
+string
+encode_data(mixed v)
+{
+  string *parts, *keys;
+  int     i;
+
+  if(intp(v))
+    return "i" + v + ";";
+  if(stringp(v))
+    return "s" + strlen(v) + ":" + v;
+  if(pointerp(v))
+  {
+    parts = allocate(sizeof(v));
+    for(i = 0; i < sizeof(v); i++)
+      parts[i] = encode_data(v[i]);
+    return "a" + sizeof(v) + ":" + implode(parts, "");
+  }
+  if(mappingp(v))
+  {
+    keys = m_indices(v);
+    parts = allocate(2 * sizeof(keys));
+    for(i = 0; i < sizeof(keys); i++)
+    {
+      parts[2 * i] = encode_data(keys[i]);
+      parts[2 * i + 1] = encode_data(v[keys[i]]);
+    }
+    return "m" + sizeof(keys) + ":" + implode(parts, "");
+  }
+  return "i0;";
+}
+
+/*
+ * Read the number at pos[0] up to <end>, leaving pos[0] after <end>.
+ */
+static int
+decode_number(string str, int *pos, int end)
+{
+  int i, n, neg;
+
+  i = pos[0];
+  if(str[i] == '-')
+  {
+    neg = 1;
+    i++;
+  }
+  for(; str[i] != end; i++)
+  {
+    if(str[i] < '0' || str[i] > '9')
+      throw("decode_data: bad number at " + i + "\n");
+    n = n * 10 + str[i] - '0';
+  }
+  pos[0] = i + 1;
+  return neg ? -n : n;
+}
+
+static mixed
+decode_at(string str, int *pos)
+{
+  mapping m;
+  mixed  *arr, key;
+  int     type, n, i;
+
+  if(pos[0] >= strlen(str))
+    throw("decode_data: truncated\n");
+  type = str[pos[0]++];
+  switch(type)
+  {
+  case 'i':
+    return decode_number(str, pos, ';');
+  case 's':
+    n = decode_number(str, pos, ':');
+    if(n < 0 || pos[0] + n > strlen(str))
+      throw("decode_data: truncated\n");
+    pos[0] += n;
+    return str[pos[0] - n..pos[0] - 1];
+  case 'a':
+    n = decode_number(str, pos, ':');
+    arr = allocate(n);
+    for(i = 0; i < n; i++)
+      arr[i] = decode_at(str, pos);
+    return arr;
+  case 'm':
+    n = decode_number(str, pos, ':');
+    m = ([ ]);
+    for(i = 0; i < n; i++)
+    {
+      key = decode_at(str, pos);
+      m[key] = decode_at(str, pos);
+    }
+    return m;
+  }
+  throw("decode_data: bad type at " + (pos[0] - 1) + "\n");
+}
+
+/*
+ * The value encoded in <str>, or 0 if <str> is not a valid encoding.
+ */
+mixed
+decode_data(string str)
+{
+  mixed v;
+
+  if(!str || catch(v = decode_at(str, ({ 0 }))))
+    return 0;
+  return v;
+}
+
+/*
+ * All values encoded one after another in <str>, as written by appending
+ * encode_data() results to a file. Stops at the first bad value.
+ */
+mixed *
+decode_data_list(string str)
+{
+  mixed *list;
+  int   *pos;
+  mixed  v;
+
+  list = ({ });
+  if(!str)
+    return list;
+  pos = ({ 0 });
+  while(pos[0] < strlen(str) && !catch(v = decode_at(str, pos)))
+    list += ({ v });
+  return list;
+}
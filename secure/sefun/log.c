@@ -0,0 +1,62 @@
+/*
+ * log.c
+ *
+ * Buffered logging. Text is collected per file and written with a single
+ * write_file() when LOG_FLUSH_TIME has passed or the buffer holds more
+ * than LOG_FLUSH_BYTES. The size check for rotation is done once per
+ * flush instead of once per line.
+ */
+
+#define LOG_FLUSH_TIME	5
+#define LOG_FLUSH_BYTES	4096
+#define MAX_LOG_SIZE	50000
+
+static mapping log_buffers = ([ ]);
+static int     log_bytes;		/* written by log_file() and here */
+
+static void
+flush_log(string file)
+{
+  string  file_name;
+  int    *st;
+
+  file_name = "/log/" + file;
+  if(sizeof(st = get_dir(file_name, 2)) && st[0] > MAX_LOG_SIZE)
+    catch(rename(file_name, file_name + ".old"));
+  write_file(file_name, log_buffers[file]);
+  log_bytes += strlen(log_buffers[file]);
+  log_buffers = m_delete(log_buffers, file);
+}
+
+void
+flush_logs()
+{
+  string *files;
+  int     i;
+
+  remove_call_out("flush_logs");
+  files = m_indices(log_buffers);
+  for(i = 0; i < sizeof(files); i++)
+    flush_log(files[i]);
+}
+
+void
+buffered_log_file(string file, string str)
+{
+  if(log_buffers[file])
+    log_buffers[file] += str;
+  else
+  {
+    log_buffers[file] = str;
+    if(find_call_out("flush_logs") == -1)
+      call_out("flush_logs", LOG_FLUSH_TIME);
+  }
+  if(strlen(log_buffers[file]) > LOG_FLUSH_BYTES)
+    flush_log(file);
+}
+
+int
+query_log_bytes()
+{
+  return log_bytes;
+}
@@ -0,0 +1,9 @@
+/*
+ * spare.c
+ *
+ * The backup simul_efun object. It is loaded next to the main object at
+ * boot but only reloaded on request, so it keeps the last working set
+ * of simul_efuns while the main one is recompiled.
+ */
+
+#include "/secure/simul_efun.c"
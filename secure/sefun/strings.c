@@ -0,0 +1,56 @@
+/*
+ * strings.c
+ *
+ * String and array helpers.
+ */
+
+/*
+ * The program an object was compiled from, with a leading slash and
+ * without clone number: "/obj/player/player".
+ */
+string
+base_name(object ob)
+{
+  string prog;
+  int    n;
+
+  if(sscanf(file_name(ob), "%s#%d", prog, n) != 2)
+    prog = file_name(ob);
+  return "/" + prog;
+}
+
+/*
+ * The elements of <arr> without duplicates, in no particular order.
+ */
+mixed *
+uniq_array(mixed *arr)
+{
+  mapping seen;
+  int     i;
+
+  seen = ([ ]);
+  for(i = 0; i < sizeof(arr); i++)
+    seen[arr[i]] = 1;
+  return m_indices(seen);
+}
+
+string
+plural(int n, string word)
+{
+  return n + " " + word + (n == 1 ? "" : "s");
+}
+
+/*
+ * A short human readable form of a number of seconds: "2d 3h", "4m 10s".
+ */
+string
+time_string(int secs)
+{
+  if(secs >= 86400)
+    return (secs / 86400) + "d " + (secs % 86400 / 3600) + "h";
+  if(secs >= 3600)
+    return (secs / 3600) + "h " + (secs % 3600 / 60) + "m";
+  if(secs >= 60)
+    return (secs / 60) + "m " + (secs % 60) + "s";
+  return secs + "s";
+}
@@ -1,7 +1,33 @@
 /*
  * simul_efun.c
+ *
+ * The stable core. Everything else lives in modules under /secure/sefun
+ * which can be reloaded with the sefun command. The master includes this
+ * file for log_file() and skips the modules; it counts the bytes it logs
+ * itself.
  */
 
+#ifndef MASTER_INCLUDE
+inherit "/secure/sefun/log";
+inherit "/secure/sefun/strings";
+inherit "/secure/sefun/codec";
+
+void
+create()
+{
+  seteuid(getuid());
+}
+#endif
+
+#ifdef MASTER_INCLUDE
+static int log_bytes;		/* written by the master's own log_file() */
+
+int
+query_log_bytes()
+{
+  return log_bytes;
+}
+#endif
 
 #define MAX_LOG_SIZE 50000
  
@@ -21,6 +47,7 @@ void log_file(string file,string str)
     if ( sizeof(st = get_dir(file_name,2) ) && st[0] > MAX_LOG_SIZE) {
 	catch(rename(file_name, file_name + ".old")); /* No panic if failure */
     }
+    log_bytes += strlen(str);
     set_this_object(previous_object());
     write_file(file_name, str);
 }
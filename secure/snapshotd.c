@@ -0,0 +1,286 @@
+/*
+ * snapshotd.c
+ *
+ * World snapshots for warm restarts. Every SNAPSHOT_TIME seconds a
+ * maintenance job (see /secure/jobd) walks the rooms known to the reset
+ * daemon a few at a time and records the clones lying in each, the room
+ * every player is in, and the state of the daemons in DAEMONS. Rooms
+ * are hashed into CHUNKS files under WORLD_DIR, written one per step.
+ * Rooms and players not back since the boot keep their old entries.
+ *
+ * At boot the master's epilog() calls boot(). Nothing is restored then:
+ * a room gets its saved contents back instead of its first reset when
+ * it is first loaded, a player goes back to their room on login, and
+ * daemons get their state back right away as they are few. Objects can keep state over a restart by
+ * returning it from query_snapshot() and taking it in restore_snapshot().
+ */
+
+#include <config.h>
+
+#define WORLD_DIR	"/save/world"
+#define SNAPSHOT_TIME	900
+#define CHUNKS		16
+#define ROOMS_PER_STEP	20
+#define DAEMONS		({ ACCOUNT_D, INTERMUD_D })
+
+static int     booted;			/* restoring from the last snapshot */
+static mapping *chunks;			/* chunk : ([ room : entries ]) */
+static mapping locations;		/* player : room */
+
+static object *snap_rooms;		/* rooms of the running snapshot */
+static mapping *snap_chunks;
+static int     snap_pos, snap_job, last_snapshot;
+
+void
+create()
+{
+  seteuid(getuid());
+  chunks = allocate(CHUNKS);
+  call_out("snapshot", SNAPSHOT_TIME);
+}
+
+static string
+room_name(object room)
+{
+  string name;
+  int    n;
+
+  if(sscanf(file_name(room), "%s#%d", name, n) == 2)
+    return 0;
+  return "/" + file_name(room);
+}
+
+static int
+chunk_of(string room)
+{
+  int h, i;
+
+  for(i = 0; i < strlen(room); i++)
+    h = (h * 31 + room[i]) & 0xffffff;
+  return h % CHUNKS;
+}
+
+/*
+ * Files are written aside and renamed over the old ones, so a crash
+ * while writing leaves the last complete file.
+ */
+static void
+write_data(string file, mixed data)
+{
+  string tmp;
+
+  file = WORLD_DIR + "/" + file;
+  tmp = file + ".tmp";
+  rm(tmp);
+  write_file(tmp, encode_data(data));
+  rename(tmp, file);
+}
+
+static mixed
+read_data(string file)
+{
+  return decode_data(read_file(WORLD_DIR + "/" + file));
+}
+
+/*
+ * Called by the master at the end of the boot.
+ */
+void
+boot()
+{
+  mapping daemons;
+  string *names;
+  int     i;
+
+  if(booted || previous_object() != find_object(MASTER))
+    return;
+  booted = 1;
+  locations = read_data("players") || ([ ]);
+  daemons = read_data("daemons") || ([ ]);
+  names = m_indices(daemons);
+  for(i = 0; i < sizeof(names); i++)
+    catch(call_other(names[i], "restore_snapshot", daemons[names[i]]));
+}
+
+/*
+ * Called by rooms right after they are created. Brings back the room's
+ * saved contents once per boot and returns 1 if there was an entry for
+ * the room, in which case it skips its first reset.
+ */
+int
+restore_room(object room)
+{
+  mapping chunk;
+  mixed  *entries;
+  object  ob;
+  string  name;
+  int     c, i;
+
+  if(!booted || !(name = room_name(room)))
+    return 0;
+  c = chunk_of(name);
+  if(!(chunk = chunks[c]))
+    chunks[c] = chunk = read_data("chunk" + c) || ([ ]);
+  if(!(entries = chunk[name]))
+    return 0;
+  chunks[c] = m_delete(chunk, name);
+  for(i = 0; i < sizeof(entries); i++)
+  {
+    if(catch(ob = POOL_D->get(entries[i][0])) || !ob)
+      continue;
+    if(entries[i][1])
+      catch(ob->restore_snapshot(entries[i][1]));
+    if(catch(ob->move(room)) || environment(ob) != room)
+      catch(destruct(ob));
+  }
+  return 1;
+}
+
+/*
+ * The room player <name> was in at the last snapshot, once.
+ */
+string
+claim_location(string name)
+{
+  string room;
+
+  if(!locations || !(room = locations[name]))
+    return 0;
+  locations = m_delete(locations, name);
+  return room;
+}
+
+/*
+ * Snapshots
+ */
+
+void
+snapshot()
+{
+  call_out("snapshot", SNAPSHOT_TIME);
+  if(snap_job && JOB_D->query_job(snap_job))
+    return;
+  snap_rooms = RESET_D->query_rooms();
+  snap_chunks = allocate(CHUNKS);
+  for(snap_pos = 0; snap_pos < CHUNKS; snap_pos++)
+    snap_chunks[snap_pos] = ([ ]);
+  snap_pos = 0;
+  snap_job = JOB_D->submit(this_object(), "snapshot_step", 1, "maintenance",
+			   "world snapshot");
+}
+
+static mixed *
+room_entries(object room)
+{
+  mixed  *entries;
+  object  ob;
+  mixed   data;
+  string  prog;
+
+  entries = ({ });
+  for(ob = first_inventory(room); ob; ob = next_inventory(ob))
+  {
+    if(interactive(ob) || ob->query_netdead() ||
+       (prog = base_name(ob)) == "/" + file_name(ob) || prog == BOT_OBJ)
+      continue;
+    catch(data = ob->query_snapshot());
+    entries += ({ ({ prog, data }) });
+  }
+  return entries;
+}
+
+/*
+ * Rooms that haven't been loaded since the boot keep their contents
+ * from the last snapshot.
+ */
+static void
+keep_unrestored(int c)
+{
+  mapping old;
+  string *names;
+  int     i;
+
+  if(!(old = chunks[c]))
+    chunks[c] = old = read_data("chunk" + c) || ([ ]);
+  names = m_indices(old);
+  for(i = 0; i < sizeof(names); i++)
+    if(!snap_chunks[c][names[i]] && !find_object(names[i]))
+      snap_chunks[c][names[i]] = old[names[i]];
+}
+
+static void
+save_rest()
+{
+  mapping players, daemons;
+  object *us;
+  string  name;
+  int     i;
+
+  players = locations ? copy_mapping(locations) : ([ ]);
+  us = users();
+  if(find_object(NETDEAD_D))
+    us += NETDEAD_D->query_statues();
+  for(i = 0; i < sizeof(us); i++)
+    if(environment(us[i]) && (name = room_name(environment(us[i]))) &&
+       us[i]->query_real_name())
+      players[us[i]->query_real_name()] = name;
+  write_data("players", players);
+  daemons = ([ ]);
+  for(i = 0; i < sizeof(DAEMONS); i++)
+    if(find_object(DAEMONS[i]))
+      catch(daemons[DAEMONS[i]] = DAEMONS[i]->query_snapshot());
+  write_data("daemons", daemons);
+}
+
+/*
+ * One step of the snapshot job: ROOMS_PER_STEP rooms, then one chunk
+ * file per step, then players and daemons.
+ */
+mixed
+snapshot_step(mixed state, int id)
+{
+  string name;
+  int    n, c;
+
+  if(previous_object() != find_object(JOB_D))
+    return 0;
+  if(file_size(WORLD_DIR) != -2)
+  {
+    if(file_size("/save") != -2)
+      mkdir("/save");
+    mkdir(WORLD_DIR);
+  }
+  if(snap_pos < sizeof(snap_rooms))
+  {
+    for(n = 0; n < ROOMS_PER_STEP && snap_pos < sizeof(snap_rooms); n++)
+    {
+      if(snap_rooms[snap_pos] && (name = room_name(snap_rooms[snap_pos])))
+	snap_chunks[chunk_of(name)][name] = room_entries(snap_rooms[snap_pos]);
+      snap_pos++;
+    }
+    JOB_D->progress(id, snap_pos, sizeof(snap_rooms) + CHUNKS);
+    return 1;
+  }
+  c = snap_pos - sizeof(snap_rooms);
+  if(c < CHUNKS)
+  {
+    if(booted)
+      keep_unrestored(c);
+    write_data("chunk" + c, snap_chunks[c]);
+    snap_pos++;
+    JOB_D->progress(id, snap_pos, sizeof(snap_rooms) + CHUNKS);
+    return 1;
+  }
+  save_rest();
+  snap_rooms = 0;
+  snap_chunks = 0;
+  snap_job = 0;
+  last_snapshot = time();
+  return 0;
+}
+
+int
+query_last_snapshot()
+{
+  return last_snapshot;
+}
@@ -0,0 +1,189 @@
+/*
+ * traced.c
+ *
+ * Function call tracing for a single object. The driver's trace() writes
+ * every call straight to the tracing user, which floods them and cannot
+ * be bounded, so instead a shadow is generated for the program of the
+ * traced object. It has a wrapper for each function of the fixed list
+ * TRACE_FUNS that function_exists() finds in the object, which takes the
+ * listed number of arguments, counts the call and passes it on. Only
+ * calls that come in through call_other, actions and driver applies are
+ * seen; calls inside the object are not.
+ *
+ * The shadow stays for at most a number of calls or seconds, after which
+ * the per-function counts and sampled eval costs are reported.
+ */
+
+#include <config.h>
+
+#define DEFAULT_CALLS	10000
+#define DEFAULT_SECS	30
+#define MAX_SECS	600
+
+/*
+ * The functions that may be traced, with their number of arguments.
+ * Functions that check previous_object() are left out, since they would
+ * see the shadow as their caller.
+ */
+#define TRACE_FUNS	([ "move" : 1, "subscribe" : 1, "unsubscribe" : 1, \
+			   "query_events" : 0, "receive_event" : 3, \
+			   "query_snapshot" : 0, "recycle" : 0, \
+			   "query_real_name" : 0, "move_player" : 1, \
+			   "set_stat" : 4, "query_stat" : 1, \
+			   "query_stat_max" : 1, "set_stat_rate" : 2, \
+			   "add_stat" : 2, "suspend_stats" : 0, \
+			   "resume_stats" : 0, "init" : 0, \
+			   "slot_reset" : 0, "query_short" : 0, \
+			   "query_long" : 0, "query_exit" : 1, \
+			   "query_dest_dir" : 0, "use_exit" : 1, \
+			   "add_exit" : 2, "remove_exit" : 1, \
+			   "save_me" : 0, "query_section" : 1, \
+			   "set_section" : 2, "throttle_input" : 1, \
+			   "command_hook" : 1, "query_admin" : 0, \
+			   "query_ignoring" : 0, "set_ignoring" : 1, \
+			   "quit" : 0, "net_dead" : 0, "reconnect" : 0, \
+			   "query_netdead" : 0, "catch_message" : 2, \
+			   "catch_tell" : 1, "more" : 5, \
+			   "query_input_stats" : 0, \
+			   "query_output_stats" : 0, "run" : 1 ])
+
+static object  tracer;			/* the active shadow */
+static object  trace_for;
+static string  last_report;
+static mapping sort_counts;
+
+void
+create()
+{
+  seteuid(getuid());
+  if(file_size(TRACE_DIR) != -2)
+    mkdir(TRACE_DIR);
+}
+
+/*
+ * Write a shadow for <ob> with a wrapper for every function of
+ * TRACE_FUNS it has. Returns its file name.
+ */
+static string
+generate(object ob, string prog)
+{
+  string *names, text, file, args, pass;
+  int     i, j;
+
+  names = m_indices(TRACE_FUNS);
+  text = "inherit \"" + TRACER + "\";\n\n";
+  for(i = 0; i < sizeof(names); i++)
+  {
+    if(!function_exists(names[i], ob))
+      continue;
+    args = pass = "";
+    for(j = 1; j <= TRACE_FUNS[names[i]]; j++)
+    {
+      args += (j > 1 ? ", " : "") + "mixed a" + j;
+      pass += ", a" + j;
+    }
+    text += "varargs mixed\n" + names[i] + "(" + args + ")\n{\n" +
+      "  return trace_leave(\"" + names[i] + "\", trace_enter(\"" +
+      names[i] + "\"),\n\t\t     call_other(victim, \"" + names[i] +
+      "\"" + pass + "));\n}\n\n";
+  }
+  file = TRACE_DIR + "/" + implode(explode(prog, "/") - ({ "" }), "_");
+  rm(file + ".c");
+  write_file(file + ".c", text);
+  return file;
+}
+
+/*
+ * Trace <ob> for at most <calls> calls or <secs> seconds. The report is
+ * sent to this_player() when the trace ends.
+ */
+string
+start(object ob, int calls, int secs)
+{
+  string  prog, file, err;
+  object  old;
+  int     n;
+
+  if(!MASTER->query_player_level("trace"))
+    return "You may not trace.\n";
+  if(tracer)
+    return "Already tracing " + file_name(tracer->query_trace_victim()) +
+      ".\n";
+  prog = file_name(ob);
+  sscanf(prog, "%s#%d", prog, n);
+  if(prog[0] != '/')
+    prog = "/" + prog;
+  if(prog == MASTER || prog == SIMUL_EFUN || prog == SEFUN_SPARE)
+    return "Can't trace " + prog + ".\n";
+
+  file = generate(ob, prog);
+  if(old = find_object(file))
+    destruct(old);
+  if(err = catch(tracer = clone_object(file)))
+    return "Can't compile the trace shadow: " + err;
+  calls = calls > 0 ? calls : DEFAULT_CALLS;
+  secs = secs > 0 && secs <= MAX_SECS ? secs : DEFAULT_SECS;
+  if(!tracer->start_trace(ob, calls, secs))
+  {
+    destruct(tracer);
+    return "Can't shadow " + file_name(ob) + ".\n";
+  }
+  trace_for = this_player();
+  return "Tracing " + file_name(ob) + " for " + calls + " calls or " +
+    secs + " seconds.\n";
+}
+
+string
+stop()
+{
+  if(!tracer)
+    return "Nothing is being traced.\n";
+  tracer->stop_trace();
+  return "Ok\n";
+}
+
+int
+by_calls(string a, string b)
+{
+  return sort_counts[a] < sort_counts[b];
+}
+
+/*
+ * Called by the shadow when it stops.
+ */
+void
+done(object victim, mapping counts, mapping costs, int calls, int secs)
+{
+  string *funs;
+  string  text;
+  mixed  *s;
+  int     i;
+
+  if(previous_object() != tracer)
+    return;
+  tracer = 0;
+  sort_counts = counts;
+  funs = sort_array(m_indices(counts), "by_calls", this_object());
+  sort_counts = 0;
+  text = sprintf("Trace of %s: %d calls in %d seconds.\n",
+		 victim ? file_name(victim) : "<destructed>", calls, secs);
+  text += sprintf("%-24s %8s %10s %8s\n", "Function", "Calls", "eval/call",
+		  "Samples");
+  for(i = 0; i < sizeof(funs); i++)
+  {
+    s = costs[funs[i]];
+    text += sprintf("%-24s %8d %10s %8d\n", funs[i], counts[funs[i]],
+		    s ? (s[1] / s[0]) + "" : "-", s ? s[0] : 0);
+  }
+  last_report = text;
+  if(trace_for)
+    trace_for->catch_message("trace", text);
+}
+
+string
+query_report()
+{
+  if(tracer)
+    return "Tracing " + file_name(tracer->query_trace_victim()) + ".\n";
+  return last_report || "No trace has been run.\n";
+}
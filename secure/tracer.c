@@ -0,0 +1,82 @@
+/*
+ * tracer.c
+ *
+ * Inherited by the shadows /secure/traced generates. Every generated
+ * function passes its call on to the shadowed object with the arguments
+ * it got, between trace_enter() and trace_leave(), which count it and
+ * measure the eval cost of every SAMPLE_EVERY'th call. The shadow
+ * removes itself after max_calls calls or when the time limit runs out,
+ * and hands its counts to the daemon.
+ */
+
+#include <config.h>
+
+#define SAMPLE_EVERY	8
+
+static object  victim;
+static mapping counts = ([ ]);		/* fun : calls */
+static mapping costs = ([ ]);		/* fun : ({ samples, eval }) */
+static int     calls, max_calls, started;
+
+int
+start_trace(object ob, int n, int secs)
+{
+  if(previous_object() != find_object(TRACE_D))
+    return 0;
+  victim = ob;
+  max_calls = n;
+  started = time();
+  if(!shadow(ob, 1))
+    return 0;
+  call_out("stop_trace", secs);
+  return 1;
+}
+
+void
+stop_trace()
+{
+  catch(TRACE_D->done(victim, counts, costs, calls, time() - started));
+  destruct(this_object());
+}
+
+/*
+ * Count a call of <fun>. Returns the eval cost left if this call is
+ * sampled, otherwise 0.
+ */
+static int
+trace_enter(string fun)
+{
+  counts[fun] = counts[fun] + 1;
+  if(++calls == max_calls)
+  {
+    remove_call_out("stop_trace");
+    call_out("stop_trace", 0);
+  }
+  if(calls % SAMPLE_EVERY)
+    return 0;
+  return get_eval_cost();
+}
+
+/*
+ * Account the eval cost of a sampled call of <fun> and pass its result
+ * <r> on.
+ */
+static mixed
+trace_leave(string fun, int cost, mixed r)
+{
+  mixed *s;
+
+  if(!cost)
+    return r;
+  if(!(s = costs[fun]))
+    costs[fun] = s = ({ 0, 0 });
+  s[0]++;
+  s[1] += cost - get_eval_cost();
+  return r;
+}
+
+object
+query_trace_victim()
+{
+  return victim;
+}